@@ -0,0 +1,173 @@
+#include "helper.h"
+
+#include "scenes.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+
+/*
+ * Benchmark Harness
+ * -----------------
+ * Runs every showcase scene from scenes.h at pinned low settings, several times each,
+ * and reports per-stage wall time (scene/BVH build, render, image output) plus render
+ * throughput (rays/sec and samples/sec) with mean and standard deviation. Image output
+ * goes to the null device, so only encoding cost is measured, not disk speed.
+ *
+ * Usage:
+ * ------
+ *   benchmark [repeats]        (default 3 repeats per scene)
+ *
+ * The pinned settings are deliberately small: the goal is comparable numbers between
+ * code revisions in minutes, not converged images.
+ */
+
+// Pinned per-scene settings so runs stay comparable across revisions
+const int bench_image_width = 256;
+const int bench_samples_per_pixel = 16;
+const int bench_max_depth = 8;
+
+// Wraps the world and counts every ray handed to it, so rays/sec can be measured
+// without instrumenting the renderer. One relaxed atomic add per ray cast (not per
+// BVH node visited) keeps the overhead in the noise.
+class counting_world : public hittable {
+public:
+	counting_world(const hittable& world) : world(world) {}
+
+	mutable std::atomic<uint64_t> rays{ 0 };
+
+	bool hit(const ray& r, interval ray_t, hit_record& rec) const override {
+		rays.fetch_add(1, std::memory_order_relaxed);
+		return world.hit(r, ray_t, rec);
+	}
+
+	void hit_packet(ray_packet& packet) const override {
+		rays.fetch_add(packet.count, std::memory_order_relaxed);
+		world.hit_packet(packet);
+	}
+
+	aabb bounding_box() const override { return world.bounding_box(); }
+
+private:
+	const hittable& world;
+};
+
+struct run_sample {
+	double build_seconds = 0;
+	double render_seconds = 0;
+	double output_seconds = 0;
+	uint64_t rays = 0;
+	uint64_t samples = 0;
+};
+
+double mean_of(const std::vector<double>& values) {
+	double sum = 0;
+	for (double value : values)
+		sum += value;
+	return sum / values.size();
+}
+
+double stddev_of(const std::vector<double>& values) {
+	if (values.size() < 2)
+		return 0;
+
+	double mean = mean_of(values);
+	double sum_squares = 0;
+	for (double value : values)
+		sum_squares += (value - mean) * (value - mean);
+	return std::sqrt(sum_squares / (values.size() - 1));
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+run_sample run_once(const std::function<scene_setup()>& build) {
+	run_sample sample;
+
+	auto build_start = std::chrono::steady_clock::now();
+	scene_setup setup = build();
+	sample.build_seconds = seconds_since(build_start);
+
+	setup.cam.image_width = bench_image_width;
+	setup.cam.samples_per_pixel = bench_samples_per_pixel;
+	setup.cam.max_depth = bench_max_depth;
+	setup.cam.checkpoint_interval = 0;
+
+	counting_world counted(setup.world);
+
+	auto render_start = std::chrono::steady_clock::now();
+	std::vector<color> frame = setup.cam.render_frame(counted);
+	sample.render_seconds = seconds_since(render_start);
+
+	sample.rays = counted.rays.load();
+	sample.samples = uint64_t(frame.size()) * bench_samples_per_pixel;
+
+#ifdef _WIN32
+	std::FILE* null_out = std::fopen("NUL", "wb");
+#else
+	std::FILE* null_out = std::fopen("/dev/null", "wb");
+#endif
+	auto output_start = std::chrono::steady_clock::now();
+	setup.cam.write_image(null_out, frame);
+	sample.output_seconds = seconds_since(output_start);
+	std::fclose(null_out);
+
+	return sample;
+}
+
+int main(int argc, char** argv) {
+	int repeats = (argc > 1) ? std::atoi(argv[1]) : 3;
+	if (repeats < 1)
+		repeats = 1;
+
+	struct bench_entry {
+		const char* name;
+		std::function<scene_setup()> build;
+	};
+
+	const bench_entry entries[] = {
+		{ "bounding_spheres",  []() { return build_bounding_spheres(); } },
+		{ "checkered_spheres", []() { return build_checkered_spheres(); } },
+		{ "earth",             []() { return build_earth(); } },
+		{ "perlin_spheres",    []() { return build_perlin_spheres(); } },
+		{ "quads",             []() { return build_quads(); } },
+		{ "simple_light",      []() { return build_simple_light(); } },
+		{ "cornell_box",       []() { return build_cornell_box(); } },
+		{ "cornell_smoke",     []() { return build_cornell_smoke(); } },
+		{ "final_scene",       []() { return build_final_scene(bench_image_width, bench_samples_per_pixel, bench_max_depth); } },
+	};
+
+	std::printf("%d repeats per scene, %dx%d-ish at %d spp, depth %d\n\n",
+		repeats, bench_image_width, bench_image_width, bench_samples_per_pixel, bench_max_depth);
+	std::printf("%-18s %13s %13s %13s %12s %12s\n",
+		"scene", "build (s)", "render (s)", "output (s)", "Mrays/s", "Msamples/s");
+
+	for (const bench_entry& entry : entries) {
+		std::vector<double> build_times, render_times, output_times, ray_rates, sample_rates;
+
+		for (int repeat = 0; repeat < repeats; repeat++) {
+			run_sample sample = run_once(entry.build);
+
+			build_times.push_back(sample.build_seconds);
+			render_times.push_back(sample.render_seconds);
+			output_times.push_back(sample.output_seconds);
+			ray_rates.push_back(sample.rays / sample.render_seconds / 1e6);
+			sample_rates.push_back(sample.samples / sample.render_seconds / 1e6);
+		}
+
+		std::printf("%-18s %6.3f\xC2\xB1%5.3f %6.3f\xC2\xB1%5.3f %6.3f\xC2\xB1%5.3f %5.2f\xC2\xB1%4.2f %5.2f\xC2\xB1%4.2f\n",
+			entry.name,
+			mean_of(build_times), stddev_of(build_times),
+			mean_of(render_times), stddev_of(render_times),
+			mean_of(output_times), stddev_of(output_times),
+			mean_of(ray_rates), stddev_of(ray_rates),
+			mean_of(sample_rates), stddev_of(sample_rates));
+		std::fflush(stdout);
+	}
+
+	return 0;
+}
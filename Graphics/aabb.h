@@ -2,6 +2,7 @@
 #define AABB_H
 
 #include "helper.h"
+#include "render_stats.h"
 
 /*
  * Axis-Aligned Bounding Box (AABB)
@@ -69,24 +70,23 @@ public:
 		- If all axes allow overlap, the ray intersects the AABB (returns true).
 	*/
 	bool hit(const ray& r, interval ray_t) const {
+		RT_STAT(aabb_tests);
+
 		const point3& ray_orig = r.origin();
-		const vec3& ray_dir = r.direction();
+		const vec3& inv_dir = r.inverse_direction(); // Cached at ray construction: no division here
 
 		for (int axis = 0; axis < 3; axis++) {
 			const interval& ax = axis_interval(axis);
-			const double adinv = 1.0 / ray_dir[axis]; // Will get infinity if we ray_dir[axis] == 0, see IEEE floating point rule #754
-
-			auto t0 = (ax.min - ray_orig[axis]) * adinv;
-			auto t1 = (ax.max - ray_orig[axis]) * adinv;
-
-			if (t0 < t1) {
-				if (t0 > ray_t.min) ray_t.min = t0;
-				if (t1 < ray_t.max) ray_t.max = t1;
-			}
-			else {
-				if (t1 > ray_t.min) ray_t.min = t1;
-				if (t0 < ray_t.max) ray_t.max = t0;
-			}
+
+			auto t0 = (ax.min - ray_orig[axis]) * inv_dir[axis];
+			auto t1 = (ax.max - ray_orig[axis]) * inv_dir[axis];
+
+			// The cached sign bit picks entry/exit without comparing t0/t1.
+			if (r.direction_is_negative(axis))
+				std::swap(t0, t1);
+
+			if (t0 > ray_t.min) ray_t.min = t0;
+			if (t1 < ray_t.max) ray_t.max = t1;
 
 			if (ray_t.max <= ray_t.min)
 				return false;
@@ -3,9 +3,15 @@
 
 #include "aabb.h"
 #include "hittable.h"
+#include "render_stats.h"
 #include "hittable_list.h"
 
 #include <algorithm>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 /*
  * Bounding Volume Hierarchy Node (BVH)
@@ -42,9 +48,108 @@
 
 
 
+// How a BVH splits its primitives at each level:
+// - median_split: sort on the longest axis and cut at the median. Cheap to build, but
+//   produces heavily overlapping siblings when primitive sizes are uneven.
+// - sah_binned: binned surface-area heuristic. Bins primitive centroids on each axis and
+//   picks the split minimizing SA(left)*N(left) + SA(right)*N(right), which tracks the
+//   expected number of box tests a random ray will pay.
+enum bvh_build { median_split, sah_binned };
+
+inline double bvh_surface_area(const aabb& box) {
+	double dx = box.x.size(), dy = box.y.size(), dz = box.z.size();
+	return 2.0 * (dx * dy + dy * dz + dz * dx);
+}
+
+// Partition hittables[start, end) with a binned SAH sweep, returning the split point and
+// the chosen axis. Falls back to a plain median when the centroids are degenerate.
+inline size_t sah_split(std::vector<shared_ptr<hittable>>& hittables, size_t start, size_t end, int& split_axis) {
+	const int bin_count = 12;
+	size_t object_span = end - start;
+
+	auto centroid = [](const shared_ptr<hittable>& object, int axis) {
+		// Copy: bounding_box() returns by value, so a reference into it would dangle.
+		interval ax = object->bounding_box().axis_interval(axis);
+		return 0.5 * (ax.min + ax.max);
+	};
+
+	// Bounds of the primitive centroids, which is what we actually bin.
+	point3 centroid_min(infinity, infinity, infinity);
+	point3 centroid_max(-infinity, -infinity, -infinity);
+	for (size_t i = start; i < end; i++) {
+		for (int axis = 0; axis < 3; axis++) {
+			double c = centroid(hittables[i], axis);
+			centroid_min[axis] = std::fmin(centroid_min[axis], c);
+			centroid_max[axis] = std::fmax(centroid_max[axis], c);
+		}
+	}
+
+	int best_axis = -1;
+	int best_bin = -1;
+	double best_cost = infinity;
+
+	for (int axis = 0; axis < 3; axis++) {
+		double extent = centroid_max[axis] - centroid_min[axis];
+		if (extent <= 1e-12)
+			continue;
+
+		aabb bin_bounds[bin_count];
+		size_t bin_counts[bin_count] = {};
+		double inv_bin_width = bin_count / extent;
+
+		for (size_t i = start; i < end; i++) {
+			int b = std::min(bin_count - 1, int((centroid(hittables[i], axis) - centroid_min[axis]) * inv_bin_width));
+			bin_counts[b]++;
+			bin_bounds[b] = aabb(bin_bounds[b], hittables[i]->bounding_box());
+		}
+
+		// Suffix-merge the bins so the right-side bounds of every candidate split are O(1).
+		aabb right_bounds[bin_count];
+		right_bounds[bin_count - 1] = bin_bounds[bin_count - 1];
+		for (int b = bin_count - 2; b >= 0; b--)
+			right_bounds[b] = aabb(bin_bounds[b], right_bounds[b + 1]);
+
+		aabb left_bounds;
+		size_t left_count = 0;
+		for (int b = 0; b < bin_count - 1; b++) {
+			left_bounds = aabb(left_bounds, bin_bounds[b]);
+			left_count += bin_counts[b];
+			size_t right_count = object_span - left_count;
+			if (left_count == 0 || right_count == 0)
+				continue;
+
+			double cost = left_count * bvh_surface_area(left_bounds) + right_count * bvh_surface_area(right_bounds[b + 1]);
+			if (cost < best_cost) {
+				best_cost = cost;
+				best_axis = axis;
+				best_bin = b;
+			}
+		}
+	}
+
+	if (best_axis < 0) {
+		// All centroids coincide; any split is as good as another.
+		split_axis = 0;
+		return start + object_span / 2;
+	}
+
+	double inv_bin_width = bin_count / (centroid_max[best_axis] - centroid_min[best_axis]);
+	auto mid_iter = std::partition(std::begin(hittables) + start, std::begin(hittables) + end,
+		[&](const shared_ptr<hittable>& object) {
+			int b = std::min(bin_count - 1, int((centroid(object, best_axis) - centroid_min[best_axis]) * inv_bin_width));
+			return b <= best_bin;
+		});
+
+	split_axis = best_axis;
+	size_t mid = mid_iter - std::begin(hittables);
+	if (mid == start || mid == end) // Shouldn't happen given the count checks above, but stay safe
+		mid = start + object_span / 2;
+	return mid;
+}
+
 class bvh_node : public hittable {
 public:
-	bvh_node(hittable_list list) : bvh_node(list.hittables, 0, list.hittables.size()) {
+	bvh_node(hittable_list list, bvh_build build = median_split) : bvh_node(list.hittables, 0, list.hittables.size(), build) {
         // There's a C++ subtlety here. This constructor (without span indices) creates an
         // implicit copy of the hittable list. The lifetime of the copied
         // list only extends until this constructor exits. That's OK, because we only need to
@@ -52,15 +157,11 @@ public:
         // https://raytracing.github.io/books/RayTracingTheNextWeek.html#boundingvolumehierarchies/thebvhnodeclass
 	}
 
-    bvh_node(std::vector<shared_ptr<hittable>>& hittables, size_t start, size_t end) {
+    bvh_node(std::vector<shared_ptr<hittable>>& hittables, size_t start, size_t end, bvh_build build = median_split) {
         bbox = aabb::empty;
         for (size_t hittable_index = start; hittable_index < end; hittable_index++)
             bbox = aabb(bbox, hittables[hittable_index]->bounding_box());
 
-        int axis = bbox.longest_axis();
-
-        auto comparator = (axis == 0) ? box_x_compare : (axis == 1) ? box_y_compare : box_z_compare;
-
         size_t object_span = end - start;
 
         if (object_span == 1) {
@@ -71,30 +172,51 @@ public:
             right = hittables[start + 1];
         }
         else {
-            std::sort(std::begin(hittables) + start, std::begin(hittables) + end, comparator);
+            size_t mid;
+
+            if (build == sah_binned) {
+                mid = sah_split(hittables, start, end, split_axis);
+            }
+            else {
+                split_axis = bbox.longest_axis();
+                auto comparator = (split_axis == 0) ? box_x_compare : (split_axis == 1) ? box_y_compare : box_z_compare;
+                std::sort(std::begin(hittables) + start, std::begin(hittables) + end, comparator);
+                mid = start + object_span / 2;
+            }
 
-            size_t mid = start + object_span / 2;
-            left = make_shared<bvh_node>(hittables, start, mid);
-            right = make_shared<bvh_node>(hittables, mid, end);
+            left = make_shared<bvh_node>(hittables, start, mid, build);
+            right = make_shared<bvh_node>(hittables, mid, end, build);
         }
     }
 
     bool hit(const ray& r, interval ray_t, hit_record& rec) const override {
+        RT_STAT(bvh_node_visits);
+
         if (!bbox.hit(r, ray_t))
             return false;
 
+        // Visit the child on the ray's near side of the split plane first, so a hit there
+        // shrinks the interval before the far child is tested (often culling it entirely).
+        const hittable* near_child = left.get();
+        const hittable* far_child = right.get();
+        if (r.direction_is_negative(split_axis))
+            std::swap(near_child, far_child);
+
         // Will stop once the object is an actual hittable and not a bvh_node.
-        bool hit_left = left->hit(r, ray_t, rec);
-        bool hit_right = right->hit(r, interval(ray_t.min, hit_left ? rec.t : ray_t.max), rec);
+        bool hit_near = near_child->hit(r, ray_t, rec);
+        bool hit_far = far_child->hit(r, interval(ray_t.min, hit_near ? rec.t : ray_t.max), rec);
 
-        return hit_left || hit_right;
+        return hit_near || hit_far;
     }
 
     aabb bounding_box() const override { return bbox; }
 private:
+    friend class scene_file;
+
     shared_ptr<hittable> left;
     shared_ptr<hittable> right;
     aabb bbox;
+    int split_axis = 0;
 
     static bool box_compare(const shared_ptr<hittable> a, const shared_ptr<hittable> b, int axis_index) {
         const interval a_axis_interval = a->bounding_box().axis_interval(axis_index);
@@ -114,4 +236,298 @@ private:
         return box_compare(a, b, 2);
     }
 };
+
+/*
+ * Flattened Bounding Volume Hierarchy (bvh_flat)
+ * ----------------------------------------------
+ * Cache-friendly alternative to the pointer-based bvh_node tree.
+ *
+ * Why:
+ * ----
+ * bvh_node stores its children behind shared_ptr<hittable> and recurses through
+ * virtual hit() calls, so every traversal step is a pointer chase into a separately
+ * heap-allocated node. On large scenes most traversal cycles stall on those cache
+ * misses rather than doing intersection math.
+ *
+ * Layout:
+ * -------
+ * - All nodes live in one contiguous array of 32-byte records (single-precision
+ *   slabs, child/primitive indices instead of pointers).
+ * - Children are stored depth-first: the left child immediately follows its parent,
+ *   only the right child index is stored. Leaves index into a shared primitive array.
+ * - Traversal is an explicit-stack loop (no recursion, no virtual dispatch between
+ *   nodes); virtual hit() is only paid at the leaves.
+ *
+ * The float slabs are rounded outward when converted from the double-precision
+ * primitive bounds, so the test stays conservative.
+ */
+
+class bvh_flat : public hittable {
+public:
+    bvh_flat(hittable_list list, bvh_build mode = median_split) : build_mode(mode) {
+        // Same implicit-copy subtlety as the bvh_node constructor: we take the list by
+        // value and keep only the primitive array it carried.
+        primitives = std::move(list.hittables);
+
+        bbox = aabb::empty;
+        for (const shared_ptr<hittable>& primitive : primitives)
+            bbox = aabb(bbox, primitive->bounding_box());
+
+        if (!primitives.empty()) {
+            nodes.reserve(2 * primitives.size());
+            build(0, primitives.size());
+        }
+    }
+
+    bool hit(const ray& r, interval ray_t, hit_record& rec) const override {
+        if (nodes.empty())
+            return false;
+
+        float origin[3], inv_dir[3];
+        for (int axis = 0; axis < 3; axis++) {
+            origin[axis] = float(r.origin()[axis]);
+            inv_dir[axis] = float(r.inverse_direction()[axis]); // Cached at ray construction
+        }
+
+        uint32_t stack[64];
+        int stack_size = 0;
+        uint32_t node_index = 0;
+
+        bool hit_anything = false;
+        double closest_so_far = ray_t.max;
+
+        while (true) {
+            const flat_node& node = nodes[node_index];
+            RT_STAT(bvh_node_visits);
+
+            if (slab_hit(node, origin, inv_dir, float(ray_t.min), float(closest_so_far))) {
+                if (node.prim_count > 0) {
+                    RT_STAT_ADD(bvh_leaf_tests, node.prim_count);
+                    for (uint16_t i = 0; i < node.prim_count; i++) {
+                        if (primitives[node.right_or_first + i]->hit(r, interval(ray_t.min, closest_so_far), rec)) {
+                            hit_anything = true;
+                            closest_so_far = rec.t;
+                        }
+                    }
+                }
+                else {
+                    // Descend into the child nearer along the split axis first, so the far
+                    // child can often be culled by the interval shrunk by a closer hit.
+                    uint32_t near_child = node_index + 1;
+                    uint32_t far_child = node.right_or_first;
+                    if (inv_dir[node.split_axis] < 0)
+                        std::swap(near_child, far_child);
+
+                    stack[stack_size++] = far_child;
+                    node_index = near_child;
+                    continue;
+                }
+            }
+
+            if (stack_size == 0)
+                break;
+            node_index = stack[--stack_size];
+        }
+
+        return hit_anything;
+    }
+
+    void hit_packet(ray_packet& packet) const override {
+        // Masked packet traversal: the whole bundle walks one shared stack, a node is
+        // descended if any ray's slab test passes, and the eight slab tests run as one
+        // SIMD comparison chain under AVX2. Individual primitive tests stay scalar and
+        // only run for the rays whose mask bit survived.
+        if (nodes.empty() || packet.count == 0)
+            return;
+
+        float origin[3][8], inv_dir[3][8], closest_f[8];
+        float t_min = float(packet.t_min);
+
+        for (int lane = 0; lane < 8; lane++) {
+            const ray& r = packet.rays[lane < packet.count ? lane : 0];
+            for (int axis = 0; axis < 3; axis++) {
+                origin[axis][lane] = float(r.origin()[axis]);
+                inv_dir[axis][lane] = float(r.inverse_direction()[axis]);
+            }
+            // Inactive lanes get an empty interval so they can never pass a slab test
+            closest_f[lane] = (lane < packet.count) ? float(packet.closest[lane]) : -std::numeric_limits<float>::infinity();
+        }
+
+        uint32_t stack[64];
+        int stack_size = 0;
+        uint32_t node_index = 0;
+
+        while (true) {
+            const flat_node& node = nodes[node_index];
+            RT_STAT(bvh_node_visits);
+            int mask = slab_hit8(node, origin, inv_dir, t_min, closest_f);
+
+            if (mask != 0) {
+                if (node.prim_count > 0) {
+                    for (int lane = 0; lane < packet.count; lane++) {
+                        if (!(mask & (1 << lane)))
+                            continue;
+
+                        RT_STAT_ADD(bvh_leaf_tests, node.prim_count);
+                        for (uint16_t p = 0; p < node.prim_count; p++) {
+                            if (primitives[node.right_or_first + p]->hit(packet.rays[lane], interval(packet.t_min, packet.closest[lane]), packet.recs[lane])) {
+                                packet.hits[lane] = true;
+                                packet.closest[lane] = packet.recs[lane].t;
+                                closest_f[lane] = float(packet.closest[lane]);
+                            }
+                        }
+                    }
+                }
+                else {
+                    // Order children by the first ray's direction; coherent packets agree.
+                    uint32_t near_child = node_index + 1;
+                    uint32_t far_child = node.right_or_first;
+                    if (inv_dir[node.split_axis][0] < 0)
+                        std::swap(near_child, far_child);
+
+                    stack[stack_size++] = far_child;
+                    node_index = near_child;
+                    continue;
+                }
+            }
+
+            if (stack_size == 0)
+                break;
+            node_index = stack[--stack_size];
+        }
+    }
+
+    aabb bounding_box() const override { return bbox; }
+
+private:
+    friend class scene_file;
+    friend class instance;
+
+    struct flat_node {
+        float    bounds[6];     // min x/y/z then max x/y/z, rounded outward from the double bounds
+        uint32_t right_or_first;// Interior: index of the right child. Leaf: first primitive index.
+        uint16_t prim_count;    // 0 for interior nodes
+        uint16_t split_axis;
+    };
+    static_assert(sizeof(flat_node) == 32, "flat_node should stay one half cache line");
+
+    std::vector<flat_node> nodes;
+    std::vector<shared_ptr<hittable>> primitives;
+    aabb bbox;
+    bvh_build build_mode;
+
+    size_t build(size_t start, size_t end) {
+        size_t node_index = nodes.size();
+        nodes.push_back(flat_node{});
+
+        aabb bounds = aabb::empty;
+        for (size_t primitive_index = start; primitive_index < end; primitive_index++)
+            bounds = aabb(bounds, primitives[primitive_index]->bounding_box());
+
+        flat_node node{};
+        for (int axis = 0; axis < 3; axis++) {
+            node.bounds[axis] = round_down(bounds.axis_interval(axis).min);
+            node.bounds[axis + 3] = round_up(bounds.axis_interval(axis).max);
+        }
+
+        size_t object_span = end - start;
+
+        if (object_span <= 2) {
+            node.right_or_first = uint32_t(start);
+            node.prim_count = uint16_t(object_span);
+        }
+        else {
+            int axis;
+            size_t mid;
+
+            if (build_mode == sah_binned) {
+                mid = sah_split(primitives, start, end, axis);
+            }
+            else {
+                axis = bounds.longest_axis();
+                auto comparator = [axis](const shared_ptr<hittable>& a, const shared_ptr<hittable>& b) {
+                    return a->bounding_box().axis_interval(axis).min < b->bounding_box().axis_interval(axis).min;
+                };
+                std::sort(std::begin(primitives) + start, std::begin(primitives) + end, comparator);
+                mid = start + object_span / 2;
+            }
+
+            node.split_axis = uint16_t(axis);
+            node.prim_count = 0;
+            build(start, mid); // Left child lands at node_index + 1 in depth-first order
+            node.right_or_first = uint32_t(build(mid, end));
+        }
+
+        // Written after the recursive calls: they may have reallocated the node array.
+        nodes[node_index] = node;
+        return node_index;
+    }
+
+    // Slab test for 8 rays against one node, returning a bitmask of the passing lanes.
+    static int slab_hit8(const flat_node& node, const float origin[3][8], const float inv_dir[3][8], float t_min, const float closest[8]) {
+#if defined(__AVX2__)
+        __m256 lane_min = _mm256_set1_ps(t_min);
+        __m256 lane_max = _mm256_loadu_ps(closest);
+
+        for (int axis = 0; axis < 3; axis++) {
+            __m256 o = _mm256_loadu_ps(origin[axis]);
+            __m256 inv = _mm256_loadu_ps(inv_dir[axis]);
+            __m256 t0 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(node.bounds[axis]), o), inv);
+            __m256 t1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(node.bounds[axis + 3]), o), inv);
+
+            lane_min = _mm256_max_ps(lane_min, _mm256_min_ps(t0, t1));
+            lane_max = _mm256_min_ps(lane_max, _mm256_max_ps(t0, t1));
+        }
+
+        return _mm256_movemask_ps(_mm256_cmp_ps(lane_max, lane_min, _CMP_GT_OQ));
+#else
+        int mask = 0;
+        for (int lane = 0; lane < 8; lane++) {
+            float lane_min = t_min;
+            float lane_max = closest[lane];
+
+            for (int axis = 0; axis < 3; axis++) {
+                float t0 = (node.bounds[axis] - origin[axis][lane]) * inv_dir[axis][lane];
+                float t1 = (node.bounds[axis + 3] - origin[axis][lane]) * inv_dir[axis][lane];
+                if (t1 < t0)
+                    std::swap(t0, t1);
+
+                if (t0 > lane_min) lane_min = t0;
+                if (t1 < lane_max) lane_max = t1;
+            }
+
+            if (lane_max > lane_min)
+                mask |= 1 << lane;
+        }
+        return mask;
+#endif
+    }
+
+    static bool slab_hit(const flat_node& node, const float origin[3], const float inv_dir[3], float t_min, float t_max) {
+        for (int axis = 0; axis < 3; axis++) {
+            float t0 = (node.bounds[axis] - origin[axis]) * inv_dir[axis];
+            float t1 = (node.bounds[axis + 3] - origin[axis]) * inv_dir[axis];
+            if (inv_dir[axis] < 0)
+                std::swap(t0, t1);
+
+            if (t0 > t_min) t_min = t0;
+            if (t1 < t_max) t_max = t1;
+
+            if (t_max <= t_min)
+                return false;
+        }
+        return true;
+    }
+
+    // Outward-rounding double->float conversions keeping the float slabs conservative.
+    static float round_down(double value) {
+        float f = float(value);
+        return (double(f) > value) ? std::nextafterf(f, -std::numeric_limits<float>::infinity()) : f;
+    }
+
+    static float round_up(double value) {
+        float f = float(value);
+        return (double(f) < value) ? std::nextafterf(f, +std::numeric_limits<float>::infinity()) : f;
+    }
+};
 #endif
@@ -3,7 +3,15 @@
 
 #include "hittable.h"
 #include "material.h"
+#include "render_pool.h"
+#include "render_stats.h"
 
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <string>
 #include <vector>
 #include <thread>
 
@@ -13,8 +21,76 @@ public:
     int         image_width          = 100;  // Rendered image width in pixel count
     int         samples_per_pixel    = 10;   // Count of random samples for each pixel, performance heavy
     uint16_t    max_depth            = 10;   // Maximum number of ray bounces into scenes
+    uint16_t    rr_min_bounces       = 4;    // Bounces before Russian roulette may terminate a path (set >= max_depth to disable)
     color background;                        // Scene background color
 
+    // Optional light list for next-event estimation. When set, diffuse bounces draw half
+    // their directions toward these objects (which must also be in the world) and the
+    // sample is reweighted by the mixture density, so small lights are found by sampling
+    // instead of by luck. Use a hittable_list to aggregate several lights.
+    //
+    // Scenes with emissive materials MUST set this: the background-only render kernel
+    // selected when it is empty skips emitted() entirely.
+    shared_ptr<hittable> lights;
+
+    // Clear this for scenes with no moving geometry: the specialized kernel then skips
+    // the per-ray time draw and traces every ray at time 0, which is distribution-
+    // identical when nothing in the scene reads the time.
+    bool motion_blur = true;
+
+    // Scheduling strategy used by render(). Fixed row bands leave cores idle once their
+    // band is done; the tiled mode keeps every core busy until the last tile is claimed.
+    enum render_schedule { scanline_bands, tiled };
+    render_schedule schedule  = tiled;
+    int             tile_size = 32;          // Tile edge length in pixels for the tiled scheduler
+
+    // Trace primary (camera) rays in 8-wide packets so the BVH can run SIMD slab tests
+    // across neighboring pixels; bounce rays are incoherent and stay scalar. Ignored in
+    // adaptive mode, whose per-pixel sample counts don't line up across a packet.
+    bool packet_primary = false;
+
+    // Output encoding written to stdout by render(). Binary P6 converts the framebuffer
+    // once and ships it in a single fwrite instead of text-formatting every channel.
+    enum output_format { ppm_ascii, ppm_binary };
+    output_format output = ppm_binary;
+
+    // Adaptive sampling: track each pixel's running mean/variance and stop sampling once
+    // the 95% confidence interval of its mean falls below the tolerance (relative to the
+    // pixel brightness). Flat regions converge after the minimum count while noisy ones
+    // still run to samples_per_pixel, which acts as the hard cap.
+    bool   adaptive_sampling    = false;
+    int    adaptive_min_samples = 64;    // Hard floor before a pixel may stop
+    int    adaptive_batch       = 32;    // Samples between convergence checks
+    double adaptive_tolerance   = 0.01;  // Relative confidence-interval threshold
+
+    // Progressive accumulation: when checkpoint_interval > 0 the frame is rendered in
+    // passes of that many samples per pixel, and after every pass the running
+    // accumulation buffer is flushed to checkpoint_path (if set). A killed run restarts
+    // from the last pass instead of from zero, and partial checkpoints double as
+    // early previews.
+    int         checkpoint_interval = 0; // Samples per pass; 0 renders in one shot
+    std::string checkpoint_path;         // Resumable accumulation state file
+
+    // Auxiliary feature buffers (AOVs): first-hit albedo, shading normal, and depth,
+    // gathered from one noise-free center ray per pixel. When aov_path_prefix is set,
+    // render() writes <prefix>_albedo.ppm, <prefix>_normal.ppm (components remapped to
+    // [0,1]) and <prefix>_depth.ppm (normalized to the farthest hit) alongside the
+    // beauty image.
+    std::string aov_path_prefix;
+
+    // Denoising post-pass: a cross-bilateral filter over the framebuffer guided by the
+    // AOVs, so pixels only blend with neighbors of similar albedo, normal, and depth.
+    // Edges and texture detail survive while low-sample noise averages out, letting a
+    // frame rendered at a fraction of the usual samples pass for a converged one.
+    bool denoise        = false;
+    int  denoise_radius = 4;   // Filter window half-width in pixels
+
+    // Traversal-cost heatmap (RT_STATS builds only; ignored otherwise): when set,
+    // render() also writes a grayscale PPM to this path where each pixel's brightness
+    // is its BVH traversal cost, showing which scene regions burn the frame budget.
+    // Recorded on the tiled scalar path, not the packet path (packets share traversal).
+    std::string heatmap_path;
+
     double vfov     = 90;               // Vertical fov
     point3 lookfrom = point3(0, 0, 0);	// Camera position
     point3 lookat   = point3(0, 0, -1);	// Camera target
@@ -24,55 +100,305 @@ public:
     double defocus_angle = 0; // Higher angle = more blur, the rays are allowed to spread more or less
     double focus_dist    = 10;// How far away is the focus plane from lookfrom 
 
+    // Safe to call repeatedly (e.g. once per frame of a batch): rendering runs on the
+    // shared persistent pool, so no threads are created or destroyed per call.
     void render(const hittable& world) {
-        initialize();
+        std::vector<color> pixel_data = render_frame(world);
+
+        render_stats_log(std::clog); // No-op unless built with RT_STATS
 
-        std::cout << "P3\n" << image_width << " " << image_height << "\n255\n";
+        write_image(stdout, pixel_data);
 
-        int num_threads = std::thread::hardware_concurrency(); // Get available CPU threads
-        int rows_per_thread = std::max(1, image_height / num_threads);
+        std::clog << "\rDone.                 \n";
+    }
+
+    // Sampling stage only: renders the frame into a framebuffer and returns it without
+    // writing any output. Split from render() so the benchmark harness (and anything
+    // else post-processing frames) can time or consume the stages separately.
+    std::vector<color> render_frame(const hittable& world) {
+        initialize();
 
+        render_stats_begin_frame();
+#ifdef RT_STATS
+        if (!heatmap_path.empty())
+            heatmap.assign(size_t(image_width) * image_height, 0.0);
+#endif
 
-        std::vector<std::thread> threads;
         std::vector<color> pixel_data(image_width * image_height);
 
-        for (int t = 0; t < num_threads; t++) {
-            int start_y = t * rows_per_thread;
-            int end_y = (t == num_threads - 1) ? image_height : (t + 1) * rows_per_thread;
+        if (checkpoint_interval > 0) {
+            render_progressive(pixel_data, world);
+        }
+        else if (schedule == tiled) {
+            render_tiled(pixel_data, world);
+        }
+        else {
+            int band_count = shared_render_pool().size();
+            int rows_per_band = std::max(1, image_height / band_count);
+
+            run_with_progress(image_height, "Rows", [&](int band, std::atomic<size_t>& done) {
+                int start_y = band * rows_per_band;
+                int end_y = (band == band_count - 1) ? image_height : (band + 1) * rows_per_band;
+
+                for (int j = start_y; j < std::min(end_y, image_height); j++) {
+                    for (int i = 0; i < image_width; i++)
+                        pixel_data[j * image_width + i] = render_pixel(i, j, world);
 
-            threads.emplace_back([this, &pixel_data, &world, start_y, end_y]() {
-                this->render_section(pixel_data, world, start_y, end_y);
+                    done.fetch_add(1, std::memory_order_relaxed);
+                }
             });
-            std::clog << "Dispatching " << start_y << " to " << end_y << " lines to thread #" << threads[t].get_id() << "\n";
+        }
 
+#ifdef RT_STATS
+        if (!heatmap.empty()) {
+            write_heatmap();
+            heatmap.clear();
         }
+#endif
+
+        if (denoise || !aov_path_prefix.empty()) {
+            aov_buffers aovs;
+            gather_aovs(world, aovs);
+
+            if (denoise)
+                pixel_data = denoise_frame(pixel_data, aovs);
 
-        for (auto& thread : threads) {
-            thread.join();
+            if (!aov_path_prefix.empty())
+                write_aovs(aovs);
         }
 
-        for (int j = 0; j < image_height; j++) {
-            for (int i = 0; i < image_width; i++) {
-                write_color(std::cout, pixel_data[j * image_width + i]);
+        return pixel_data;
+    }
+
+    // Output stage: encodes a framebuffer from render_frame() in the configured format.
+    void write_image(std::FILE* out, const std::vector<color>& pixel_data) const {
+        if (output == ppm_binary) {
+            write_ppm_binary(out, pixel_data, image_width, image_height);
+        }
+        else {
+            std::fprintf(out, "P3\n%d %d\n255\n", image_width, image_height);
+
+            for (const color& pixel_color : pixel_data) {
+                unsigned char bytes[3];
+                color_to_bytes(pixel_color, bytes);
+                std::fprintf(out, "%d %d %d\n", bytes[0], bytes[1], bytes[2]);
             }
         }
+    }
 
-        std::clog << "\rDone.                 \n";
+    void render_tiled(std::vector<color>& pixel_data, const hittable& world) {
+        struct tile { int x0, y0, x1, y1; };
+
+        std::vector<tile> tiles;
+        for (int y = 0; y < image_height; y += tile_size)
+            for (int x = 0; x < image_width; x += tile_size)
+                tiles.push_back({ x, y, std::min(x + tile_size, image_width), std::min(y + tile_size, image_height) });
+
+        std::atomic<size_t> next_tile(0);
+
+        run_with_progress(tiles.size(), "Tiles", [&](int, std::atomic<size_t>& done) {
+            // Worker-local accumulation buffer: allocated and first-touched on this
+            // thread, so its pages land in this worker's own NUMA node's memory (the
+            // pool pins workers to their hardware threads); aligned and padded to
+            // cache lines so no two workers ever share a line while sampling; reused
+            // for every tile this worker claims. Only the one copy per finished tile
+            // into the shared framebuffer ever crosses between nodes.
+            tile_accumulator accumulator(size_t(tile_size) * tile_size);
+
+            for (size_t tile_index = next_tile.fetch_add(1); tile_index < tiles.size(); tile_index = next_tile.fetch_add(1)) {
+                const tile& current = tiles[tile_index];
+                int tile_width = current.x1 - current.x0;
+
+                if (packet_primary && !adaptive_sampling) {
+                    render_tile_packets(accumulator.data, tile_width, world, current.x0, current.y0, current.x1, current.y1);
+                }
+                else {
+                    for (int j = current.y0; j < current.y1; j++) {
+                        for (int i = current.x0; i < current.x1; i++) {
+                            uint64_t cost_before = render_stats_traversal_count();
+
+                            accumulator.data[(j - current.y0) * tile_width + (i - current.x0)] = render_pixel(i, j, world);
+
+                            if (!heatmap.empty())
+                                heatmap[size_t(j) * image_width + i] = double(render_stats_traversal_count() - cost_before);
+                        }
+                    }
+                }
+
+                for (int j = current.y0; j < current.y1; j++)
+                    std::copy(accumulator.data + (j - current.y0) * tile_width,
+                              accumulator.data + (j - current.y0 + 1) * tile_width,
+                              pixel_data.begin() + j * image_width + current.x0);
+
+                done.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
     }
 
-    void render_section(std::vector<color>& pixel_data, const hittable& world, int start_y, int end_y) {
-        for (int j = start_y; j < end_y; j++) {
-            for (int i = 0; i < image_width; i++) {
-                color pixel_color(0, 0, 0);
-                for (int sample = 0; sample < samples_per_pixel; sample++) {
-                    ray r = get_ray(i, j);
-                    pixel_color += ray_color(r, max_depth, world);
+    void render_progressive(std::vector<color>& pixel_data, const hittable& world) {
+        std::vector<color> accumulation(image_width * image_height);
+        int samples_done = 0;
+
+        if (!checkpoint_path.empty() && load_checkpoint(accumulation, samples_done))
+            std::clog << "Resumed checkpoint '" << checkpoint_path << "' at " << samples_done << " samples per pixel\n";
+
+        while (samples_done < samples_per_pixel) {
+            int pass_samples = std::min(checkpoint_interval, samples_per_pixel - samples_done);
+
+            dispatch_tiles([this, &accumulation, &world, pass_samples](int x0, int y0, int x1, int y1) {
+                for (int j = y0; j < y1; j++)
+                    for (int i = x0; i < x1; i++)
+                        accumulation[j * image_width + i] += sample_pixel_sum(i, j, world, pass_samples);
+            });
+
+            samples_done += pass_samples;
+
+            if (!checkpoint_path.empty())
+                save_checkpoint(accumulation, samples_done);
+
+            std::clog << "Pass complete: " << samples_done << "/" << samples_per_pixel << " samples per pixel\n";
+        }
+
+        for (size_t pixel_index = 0; pixel_index < accumulation.size(); pixel_index++)
+            pixel_data[pixel_index] = accumulation[pixel_index] / samples_done;
+    }
+
+    // Batch rendering: renders frame_count frames against one world, calling
+    // configure(frame_index, camera&) before each so animations just move the public
+    // camera fields between frames. The caller builds the scene (and its BVH) once and
+    // the persistent pool survives across frames, so none of the per-invocation setup
+    // cost of rendering each frame in its own process is paid. Each finished frame is
+    // encoded and written to path_pattern (printf-style, given the frame index) on a
+    // writer thread while the next frame renders, so output I/O overlaps sampling
+    // instead of stalling the cores between frames.
+    template <class Configure>
+    void render_sequence(const hittable& world, int frame_count, const std::string& path_pattern, Configure&& configure) {
+        std::thread writer;
+
+        for (int frame = 0; frame < frame_count; frame++) {
+            configure(frame, *this);
+
+            std::clog << "Frame " << (frame + 1) << "/" << frame_count << "\n";
+            std::vector<color> pixel_data = render_frame(world);
+
+            // Capture everything the writer needs by value: the next frame's
+            // initialize() may change the image dimensions under a live writer.
+            char path[512];
+            std::snprintf(path, sizeof(path), path_pattern.c_str(), frame);
+            int frame_width = image_width, frame_height = image_height;
+            output_format frame_format = output;
+
+            if (writer.joinable())
+                writer.join();
+
+            writer = std::thread([pixel_data = std::move(pixel_data), path = std::string(path),
+                                  frame_width, frame_height, frame_format]() {
+                std::FILE* out = std::fopen(path.c_str(), "wb");
+                if (!out) {
+                    std::clog << "Could not write frame '" << path << "'\n";
+                    return;
                 }
 
-                pixel_data[j * image_width + i] = pixel_samples_scale * pixel_color;
+                if (frame_format == ppm_binary) {
+                    write_ppm_binary(out, pixel_data, frame_width, frame_height);
+                }
+                else {
+                    std::fprintf(out, "P3\n%d %d\n255\n", frame_width, frame_height);
+                    for (const color& pixel_color : pixel_data) {
+                        unsigned char bytes[3];
+                        color_to_bytes(pixel_color, bytes);
+                        std::fprintf(out, "%d %d %d\n", bytes[0], bytes[1], bytes[2]);
+                    }
+                }
+
+                std::fclose(out);
+            });
+        }
+
+        if (writer.joinable())
+            writer.join();
+    }
+
+    // Distributed rendering, worker side: renders only this worker's share of
+    // samples_per_pixel (the total split as evenly as worker_count allows) and writes
+    // the raw accumulation buffer plus its sample count to partial_path, in the same
+    // RTCP layout as checkpoints. Every worker traces the full frame, so splitting by
+    // sample share keeps the per-node load even regardless of where the expensive
+    // pixels are; the farm scheduler acts as the coordinator by launching one worker
+    // per (index, count) pair and running merge_partials when they are all done.
+    bool render_partial(const hittable& world, int worker_index, int worker_count, const std::string& partial_path) {
+        initialize();
+
+        // First (samples % count) workers take one extra sample so the shares sum exactly.
+        int share = samples_per_pixel / worker_count + (worker_index < samples_per_pixel % worker_count ? 1 : 0);
+        if (share == 0) {
+            std::clog << "Worker " << worker_index << " has no samples to render (more workers than samples)\n";
+            return false;
+        }
+
+        // Decorrelate this process's RNG streams from every other worker's. The offset
+        // just has to exceed any plausible thread count so the seed tickets never collide.
+        rng_stream_offset() = uint64_t(worker_index) << 32;
+
+        std::vector<color> accumulation(image_width * image_height);
+
+        dispatch_tiles([this, &accumulation, &world, share](int x0, int y0, int x1, int y1) {
+            for (int j = y0; j < y1; j++)
+                for (int i = x0; i < x1; i++)
+                    accumulation[j * image_width + i] = sample_pixel_sum(i, j, world, share);
+        });
+
+        if (!write_accumulation(partial_path, accumulation, share))
+            return false;
+
+        std::clog << "Worker " << worker_index << "/" << worker_count << " wrote " << share
+                  << " samples per pixel to '" << partial_path << "'\n";
+        return true;
+    }
+
+    // Distributed rendering, merge side: sums the workers' partial accumulation
+    // buffers, divides by the total sample count, and writes the finished image in the
+    // configured output format. The partials carry their own resolution, so merging
+    // needs no scene file.
+    bool merge_partials(const std::vector<std::string>& partial_paths, std::FILE* out) {
+        std::vector<color> total;
+        long total_samples = 0;
+
+        for (const std::string& path : partial_paths) {
+            std::vector<color> partial;
+            int width = 0, height = 0, samples = 0;
+
+            if (!read_accumulation(path, partial, width, height, samples)) {
+                std::clog << "Could not read partial '" << path << "'\n";
+                return false;
+            }
+
+            if (total.empty()) {
+                image_width = width;
+                image_height = height;
+                total.assign(partial.size(), color(0, 0, 0));
+            }
+            else if (width != image_width || height != image_height) {
+                std::clog << "Partial '" << path << "' is " << width << "x" << height
+                          << ", expected " << image_width << "x" << image_height << "\n";
+                return false;
             }
-            std::clog << "Thread " << std::this_thread::get_id() <<  " wrote line " << j << "\n";
+
+            for (size_t pixel_index = 0; pixel_index < total.size(); pixel_index++)
+                total[pixel_index] += partial[pixel_index];
+            total_samples += samples;
         }
+
+        if (total_samples == 0)
+            return false;
+
+        std::vector<color> pixel_data(total.size());
+        for (size_t pixel_index = 0; pixel_index < total.size(); pixel_index++)
+            pixel_data[pixel_index] = total[pixel_index] / double(total_samples);
+
+        write_image(out, pixel_data);
+        std::clog << "Merged " << partial_paths.size() << " partials, " << total_samples << " samples per pixel\n";
+        return true;
     }
 
 private:
@@ -85,6 +411,7 @@ private:
     vec3   u, v, w;             // Camera frame basis vectors (allows us to have a orthogonal reference)
     vec3   defocus_disk_u;      // Defocus disk horizontal radius
     vec3   defocus_disk_v;      // Defocus disk vertical radius
+    std::vector<double> heatmap; // Per-pixel traversal cost, only allocated in RT_STATS builds
 
 	void initialize() {
         image_height = int(image_width / aspect_ratio);
@@ -123,18 +450,231 @@ private:
         defocus_disk_v = v * defocus_radius;
 	}
 
-    ray get_ray(int i, int j) const {
-        // Construct a camera ray originating from the defocus disk and directed at a randomly
-        // sampled point around the pixel location i, j.
-        
-        vec3 offset = sample_square();
+    // Runs job(worker_index, done_counter) on every pool worker while a single reporter
+    // thread samples the counter twice a second. Workers only bump an atomic, so the
+    // render path never serializes on the clog stream lock the way per-line logging did.
+    template <class Job>
+    void run_with_progress(size_t total, const char* label, Job&& job) const {
+        std::atomic<size_t> done(0);
+
+        // The reporter waits on a condition variable rather than plain sleeps, so
+        // finishing the job wakes it immediately instead of up to a period later.
+        std::mutex finished_mutex;
+        std::condition_variable finished_cv;
+        bool finished = false;
+
+        std::thread reporter([&]() {
+            std::unique_lock<std::mutex> lock(finished_mutex);
+            while (!finished) {
+                std::clog << "\r" << label << ": " << done.load() << "/" << total << "     " << std::flush;
+                finished_cv.wait_for(lock, std::chrono::milliseconds(500), [&]() { return finished; });
+            }
+            std::clog << "\r" << label << ": " << total << "/" << total << "     \n";
+        });
+
+        shared_render_pool().run([&](int worker_index) {
+            job(worker_index, done);
+            render_stats_flush_thread(); // Merge this worker's counters (no-op without RT_STATS)
+        });
+
+        {
+            std::lock_guard<std::mutex> lock(finished_mutex);
+            finished = true;
+        }
+        finished_cv.notify_one();
+        reporter.join();
+    }
+
+    // Run tile_func(x0, y0, x1, y1) for every tile on the shared pool, with workers
+    // claiming tiles from a shared atomic ticket (see render_tiled).
+    template <class TileFunc>
+    void dispatch_tiles(TileFunc&& tile_func) {
+        struct tile { int x0, y0, x1, y1; };
+
+        std::vector<tile> tiles;
+        for (int y = 0; y < image_height; y += tile_size)
+            for (int x = 0; x < image_width; x += tile_size)
+                tiles.push_back({ x, y, std::min(x + tile_size, image_width), std::min(y + tile_size, image_height) });
+
+        // Shared work queue: workers claim the next unfinished tile with an atomic ticket,
+        // so a thread that lands on cheap sky tiles immediately steals more work instead of
+        // idling behind a thread stuck on an expensive band.
+        std::atomic<size_t> next_tile(0);
+
+        run_with_progress(tiles.size(), "Tiles", [&](int, std::atomic<size_t>& done) {
+            for (size_t tile_index = next_tile.fetch_add(1); tile_index < tiles.size(); tile_index = next_tile.fetch_add(1)) {
+                const tile& current = tiles[tile_index];
+                tile_func(current.x0, current.y0, current.x1, current.y1);
+
+                done.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+
+    // Fills a tile-local buffer (dest_stride colors per row, origin at x0/y0).
+    void render_tile_packets(color* dest, int dest_stride, const hittable& world, int x0, int y0, int x1, int y1) const {
+        with_feature_kernel([&](auto use_defocus, auto use_motion, auto use_lights) {
+            render_tile_packets<use_defocus.value, use_motion.value, use_lights.value>(dest, dest_stride, world, x0, y0, x1, y1);
+        });
+    }
+
+    template <bool with_defocus, bool with_motion, bool with_lights>
+    void render_tile_packets(color* dest, int dest_stride, const hittable& world, int x0, int y0, int x1, int y1) const {
+        int grid = int(std::sqrt(double(samples_per_pixel)));
+        double recip_grid = (grid > 0) ? 1.0 / grid : 1.0;
+
+        for (int j = y0; j < y1; j++) {
+            for (int i = x0; i < x1; i += 8) {
+                int count = std::min(8, x1 - i);
+                color sums[8] = {};
+
+                // All lanes of a packet share one sample index, so each primary bundle is
+                // 8 neighboring pixels sampling the same sub-pixel stratum: maximally
+                // coherent for the shared BVH traversal.
+                for (int sample = 0; sample < samples_per_pixel; sample++) {
+                    vec3 offset = (sample < grid * grid)
+                        ? sample_square_stratified(sample % grid, sample / grid, recip_grid)
+                        : sample_square();
+
+                    RT_STAT_ADD(primary_rays, count);
+
+                    ray_packet packet;
+                    packet.init(count, interval(0.001, infinity));
+                    for (int lane = 0; lane < count; lane++)
+                        packet.rays[lane] = get_ray<with_defocus, with_motion>(i + lane, j, offset);
+
+                    world.hit_packet(packet);
+
+                    for (int lane = 0; lane < count; lane++)
+                        sums[lane] += ray_color_shaded<with_lights>(packet.rays[lane], max_depth, world, packet.hits[lane], packet.recs[lane]);
+                }
+
+                for (int lane = 0; lane < count; lane++)
+                    dest[(j - y0) * dest_stride + (i - x0) + lane] = pixel_samples_scale * sums[lane];
+            }
+        }
+    }
+
+    // Invokes fn with three std::bool_constant tags matching the camera's enabled
+    // features (defocus, motion blur, light sampling), so the per-ray kernels reached
+    // through it are compiled once per feature combination with the disabled features'
+    // branches and RNG draws removed entirely. The dispatch itself is three predictable
+    // branches, paid per pixel rather than per ray.
+    template <class Fn>
+    void with_feature_kernel(Fn&& fn) const {
+        auto pick_lights = [&](auto use_defocus, auto use_motion) {
+            if (lights) fn(use_defocus, use_motion, std::true_type{});
+            else        fn(use_defocus, use_motion, std::false_type{});
+        };
+        auto pick_motion = [&](auto use_defocus) {
+            if (motion_blur) pick_lights(use_defocus, std::true_type{});
+            else             pick_lights(use_defocus, std::false_type{});
+        };
+        if (defocus_angle > 0) pick_motion(std::true_type{});
+        else                   pick_motion(std::false_type{});
+    }
+
+    color render_pixel(int i, int j, const hittable& world) const {
+        color result;
+        with_feature_kernel([&](auto use_defocus, auto use_motion, auto use_lights) {
+            if (adaptive_sampling)
+                result = render_pixel_adaptive<use_defocus.value, use_motion.value, use_lights.value>(i, j, world);
+            else
+                result = pixel_samples_scale * sample_pixel_sum<use_defocus.value, use_motion.value, use_lights.value>(i, j, world, samples_per_pixel);
+        });
+        return result;
+    }
+
+    color sample_pixel_sum(int i, int j, const hittable& world, int sample_count) const {
+        color result;
+        with_feature_kernel([&](auto use_defocus, auto use_motion, auto use_lights) {
+            result = sample_pixel_sum<use_defocus.value, use_motion.value, use_lights.value>(i, j, world, sample_count);
+        });
+        return result;
+    }
+
+    template <bool with_defocus, bool with_motion, bool with_lights>
+    color sample_pixel_sum(int i, int j, const hittable& world, int sample_count) const {
+        color pixel_color(0, 0, 0);
+
+        // Stratified samples: one jittered sample per cell of a grid x grid sub-pixel
+        // lattice, which converges noticeably faster than the same number of uniform
+        // draws. Samples beyond the square grid fall back to uniform jitter.
+        int grid = int(std::sqrt(double(sample_count)));
+        double recip_grid = (grid > 0) ? 1.0 / grid : 1.0;
+
+        for (int s_j = 0; s_j < grid; s_j++) {
+            for (int s_i = 0; s_i < grid; s_i++) {
+                ray r = get_ray<with_defocus, with_motion>(i, j, sample_square_stratified(s_i, s_j, recip_grid));
+                pixel_color += ray_color<with_lights>(r, max_depth, world);
+            }
+        }
+
+        for (int sample = grid * grid; sample < sample_count; sample++) {
+            ray r = get_ray<with_defocus, with_motion>(i, j, sample_square());
+            pixel_color += ray_color<with_lights>(r, max_depth, world);
+        }
+
+        return pixel_color;
+    }
+
+    template <bool with_defocus, bool with_motion, bool with_lights>
+    color render_pixel_adaptive(int i, int j, const hittable& world) const {
+        // Welford accumulation of the sample luminance so mean and variance stay
+        // numerically stable over thousands of samples. Stratification needs the sample
+        // count up front, so this path uses plain jittered samples.
+        color pixel_color(0, 0, 0);
+        double mean = 0;
+        double m2 = 0;
+        int sample_count = 0;
+
+        while (sample_count < samples_per_pixel) {
+            ray r = get_ray<with_defocus, with_motion>(i, j, sample_square());
+            color sample = ray_color<with_lights>(r, max_depth, world);
+
+            pixel_color += sample;
+            sample_count++;
+
+            double lum = luminance(sample);
+            double delta = lum - mean;
+            mean += delta / sample_count;
+            m2 += delta * (lum - mean);
+
+            if (sample_count >= adaptive_min_samples && sample_count % adaptive_batch == 0) {
+                double variance = m2 / (sample_count - 1);
+                double ci_half_width = 1.96 * std::sqrt(variance / sample_count);
+
+                // Relative test, floored so near-black pixels don't demand absolute precision
+                if (ci_half_width <= adaptive_tolerance * std::fmax(mean, 0.01))
+                    break;
+            }
+        }
+
+        return pixel_color / double(sample_count);
+    }
+
+    // Specialized on the camera's feature set: with defocus or motion blur compiled
+    // out, the corresponding RNG draws and the defocus branch vanish from the per-ray
+    // path instead of being tested and skipped billions of times.
+    template <bool with_defocus, bool with_motion>
+    ray get_ray(int i, int j, const vec3& offset) const {
+        // Construct a camera ray originating from the defocus disk and directed at the
+        // point offset from the pixel location i, j by the given sub-pixel offset.
+
         point3 pixel_sample = pixel00_loc + ((i + offset.x()) * pixel_delta_u) + ((j + offset.y()) * pixel_delta_v);
 
-        point3 ray_origin = (defocus_angle <= 0) ? center : defocus_disk_sample();
+        point3 ray_origin = with_defocus ? defocus_disk_sample() : center;
         vec3 ray_direction = pixel_sample - ray_origin;
-        double ray_time = random_double();
+        double ray_time = with_motion ? random_double() : 0.0;
+
+        ray r(ray_origin, ray_direction, ray_time);
 
-        return ray(ray_origin, ray_direction, ray_time);
+        // Pixel footprint: this ray stands in for a pixel-wide beam, which widens by
+        // about one pixel-spacing per pixel-distance traveled. Textures use it to pick
+        // a mip level matched to what the pixel can actually resolve.
+        r.set_spread(pixel_delta_u.length() / ray_direction.length());
+
+        return r;
     }
 
     vec3 sample_square() const {
@@ -142,39 +682,385 @@ private:
         return vec3(random_double() - 0.5, random_double() - 0.5, 0);
     }
 
+    vec3 sample_square_stratified(int s_i, int s_j, double recip_grid) const {
+        // Returns the vector to a random point in the sub-pixel cell (s_i, s_j) of the
+        // stratification grid laid over the [-.5,-.5]-[+.5,+.5] unit square.
+        double px = ((s_i + random_double()) * recip_grid) - 0.5;
+        double py = ((s_j + random_double()) * recip_grid) - 0.5;
+        return vec3(px, py, 0);
+    }
+
+    // Reads an RTCP accumulation file (checkpoint or distributed partial) at its own
+    // resolution; the caller decides whether the dimensions are acceptable.
+    static bool read_accumulation(const std::string& path, std::vector<color>& accumulation, int& width, int& height, int& samples_done) {
+        std::FILE* file = std::fopen(path.c_str(), "rb");
+        if (!file)
+            return false;
+
+        char magic[4] = {};
+
+        bool ok = std::fread(magic, 1, 4, file) == 4
+            && std::memcmp(magic, "RTCP", 4) == 0
+            && std::fread(&width, sizeof(int), 1, file) == 1
+            && std::fread(&height, sizeof(int), 1, file) == 1
+            && std::fread(&samples_done, sizeof(int), 1, file) == 1
+            && width > 0 && height > 0;
+
+        if (ok) {
+            accumulation.resize(size_t(width) * height);
+            ok = std::fread(accumulation.data(), sizeof(color), accumulation.size(), file) == accumulation.size();
+        }
+
+        std::fclose(file);
+        return ok;
+    }
+
+    bool load_checkpoint(std::vector<color>& accumulation, int& samples_done) const {
+        std::vector<color> loaded;
+        int file_width = 0, file_height = 0, file_samples = 0;
+
+        if (!read_accumulation(checkpoint_path, loaded, file_width, file_height, file_samples))
+            return false;
+
+        if (file_width != image_width || file_height != image_height) {
+            std::clog << "Ignoring checkpoint '" << checkpoint_path << "': wrong format or resolution\n";
+            return false;
+        }
+
+        accumulation = std::move(loaded);
+        samples_done = file_samples;
+        return true;
+    }
+
+    bool write_accumulation(const std::string& path, const std::vector<color>& accumulation, int samples_done) const {
+        // Write to a sibling temp file and rename it over the target, so a kill
+        // mid-flush can never leave a torn state file behind.
+        std::string temp_path = path + ".tmp";
+
+        std::FILE* file = std::fopen(temp_path.c_str(), "wb");
+        if (!file) {
+            std::clog << "Could not write '" << temp_path << "'\n";
+            return false;
+        }
+
+        std::fwrite("RTCP", 1, 4, file);
+        std::fwrite(&image_width, sizeof(int), 1, file);
+        std::fwrite(&image_height, sizeof(int), 1, file);
+        std::fwrite(&samples_done, sizeof(int), 1, file);
+        std::fwrite(accumulation.data(), sizeof(color), accumulation.size(), file);
+        std::fclose(file);
+
+        std::remove(path.c_str());
+        std::rename(temp_path.c_str(), path.c_str());
+        return true;
+    }
+
+    void save_checkpoint(const std::vector<color>& accumulation, int samples_done) const {
+        write_accumulation(checkpoint_path, accumulation, samples_done);
+    }
+
+    // Grayscale P6 of the recorded per-pixel traversal cost, normalized to the frame's
+    // maximum so the hottest pixel is white.
+    void write_heatmap() const {
+        double max_cost = 0;
+        for (double cost : heatmap)
+            max_cost = std::fmax(max_cost, cost);
+
+        std::FILE* out = std::fopen(heatmap_path.c_str(), "wb");
+        if (!out) {
+            std::clog << "Could not write heatmap '" << heatmap_path << "'\n";
+            return;
+        }
+
+        std::fprintf(out, "P6\n%d %d\n255\n", image_width, image_height);
+
+        std::vector<unsigned char> bytes(heatmap.size() * 3);
+        for (size_t i = 0; i < heatmap.size(); i++) {
+            unsigned char level = (max_cost > 0) ? (unsigned char)(255.0 * heatmap[i] / max_cost) : 0;
+            bytes[i * 3] = bytes[i * 3 + 1] = bytes[i * 3 + 2] = level;
+        }
+
+        std::fwrite(bytes.data(), 1, bytes.size(), out);
+        std::fclose(out);
+
+        std::clog << "Wrote traversal heatmap '" << heatmap_path << "'\n";
+    }
+
+    // Cache-line-aligned color buffer, padded to whole lines. Construct it on the
+    // worker thread that renders into it: first touch is what places the pages, so a
+    // buffer touched on its own (pinned) worker stays in node-local memory.
+    struct tile_accumulator {
+        color* data;
+
+        explicit tile_accumulator(size_t count) {
+            size_t bytes = (count * sizeof(color) + 63) & ~size_t(63);
+            data = static_cast<color*>(::operator new(bytes, std::align_val_t(64)));
+            for (size_t i = 0; i < count; i++)
+                new (data + i) color();
+        }
+
+        ~tile_accumulator() { ::operator delete(data, std::align_val_t(64)); }
+
+        tile_accumulator(const tile_accumulator&) = delete;
+        tile_accumulator& operator=(const tile_accumulator&) = delete;
+    };
+
+    struct aov_buffers {
+        std::vector<color>  albedo; // First-hit base color (white where nothing was hit)
+        std::vector<vec3>   normal; // First-hit shading normal (zero where nothing was hit)
+        std::vector<double> depth;  // World-space distance to the first hit (infinity for misses)
+    };
+
+    // One deterministic center ray per pixel: no sub-pixel jitter, no defocus, time 0.
+    // The feature buffers must be noise-free, or the denoiser would smear the beauty
+    // image along their noise instead of along real edges.
+    void gather_aovs(const hittable& world, aov_buffers& aovs) {
+        size_t pixel_count = size_t(image_width) * image_height;
+        aovs.albedo.assign(pixel_count, color(1, 1, 1));
+        aovs.normal.assign(pixel_count, vec3(0, 0, 0));
+        aovs.depth.assign(pixel_count, infinity);
+
+        dispatch_tiles([this, &world, &aovs](int x0, int y0, int x1, int y1) {
+            for (int j = y0; j < y1; j++) {
+                for (int i = x0; i < x1; i++) {
+                    point3 pixel_sample = pixel00_loc + (i * pixel_delta_u) + (j * pixel_delta_v);
+                    ray r(center, pixel_sample - center, 0);
+
+                    hit_record rec;
+                    if (!world.hit(r, interval(0.001, infinity), rec))
+                        continue;
+
+                    size_t pixel_index = size_t(j) * image_width + i;
+                    aovs.albedo[pixel_index] = rec.mat->base_color(rec.u, rec.v, rec.p);
+                    aovs.normal[pixel_index] = rec.normal;
+                    aovs.depth[pixel_index] = rec.t * r.direction().length();
+                }
+            }
+        });
+    }
+
+    // Cross-bilateral filter guided by the feature buffers. Radiance is demodulated by
+    // the albedo before filtering and remodulated after, so texture detail passes
+    // through untouched while the lighting noise underneath it is averaged. Each
+    // neighbor's weight combines a spatial falloff with normal, depth, and albedo
+    // affinity; sky pixels (no depth) only ever blend with other sky pixels.
+    std::vector<color> denoise_frame(const std::vector<color>& noisy, const aov_buffers& aovs) {
+        auto demodulate = [](const color& c, const color& albedo) {
+            return color(c.x() / std::fmax(double(albedo.x()), 1e-3),
+                         c.y() / std::fmax(double(albedo.y()), 1e-3),
+                         c.z() / std::fmax(double(albedo.z()), 1e-3));
+        };
+
+        std::vector<color> irradiance(noisy.size());
+        for (size_t pixel_index = 0; pixel_index < noisy.size(); pixel_index++)
+            irradiance[pixel_index] = demodulate(noisy[pixel_index], aovs.albedo[pixel_index]);
+
+        double sigma_spatial = std::fmax(1.0, denoise_radius * 0.5);
+        double spatial_scale = -1.0 / (2 * sigma_spatial * sigma_spatial);
+
+        std::vector<color> filtered(noisy.size());
+
+        dispatch_tiles([&, this](int x0, int y0, int x1, int y1) {
+            for (int j = y0; j < y1; j++) {
+                for (int i = x0; i < x1; i++) {
+                    size_t center_index = size_t(j) * image_width + i;
+                    const vec3& n0 = aovs.normal[center_index];
+                    double z0 = aovs.depth[center_index];
+                    bool sky0 = (z0 == infinity);
+
+                    color sum = irradiance[center_index];
+                    double total_weight = 1.0; // Center pixel always contributes fully
+
+                    for (int dj = -denoise_radius; dj <= denoise_radius; dj++) {
+                        for (int di = -denoise_radius; di <= denoise_radius; di++) {
+                            if (di == 0 && dj == 0)
+                                continue;
+
+                            int x = i + di, y = j + dj;
+                            if (x < 0 || x >= image_width || y < 0 || y >= image_height)
+                                continue;
+
+                            size_t neighbor_index = size_t(y) * image_width + x;
+                            bool sky = (aovs.depth[neighbor_index] == infinity);
+                            if (sky != sky0)
+                                continue;
+
+                            double weight = std::exp(spatial_scale * (di * di + dj * dj));
+
+                            if (!sky0) {
+                                // Surface affinity: aligned normals, similar depth
+                                // (relative, so distant geometry is not over-split),
+                                // and similar albedo.
+                                double facing = std::fmax(0.0, double(dot(n0, aovs.normal[neighbor_index])));
+                                weight *= facing * facing * facing * facing;
+
+                                double depth_gap = std::fabs(aovs.depth[neighbor_index] - z0) / (0.02 * z0);
+                                weight *= std::exp(-depth_gap);
+
+                                vec3 albedo_gap = aovs.albedo[neighbor_index] - aovs.albedo[center_index];
+                                weight *= std::exp(-16.0 * double(albedo_gap.length_squared()));
+                            }
+
+                            sum += weight * irradiance[neighbor_index];
+                            total_weight += weight;
+                        }
+                    }
+
+                    filtered[center_index] = (sum / total_weight) * aovs.albedo[center_index];
+                }
+            }
+        });
+
+        return filtered;
+    }
+
+    void write_aovs(const aov_buffers& aovs) const {
+        write_aov_image(aov_path_prefix + "_albedo.ppm", aovs.albedo);
+
+        std::vector<color> normal_image(aovs.normal.size());
+        for (size_t pixel_index = 0; pixel_index < aovs.normal.size(); pixel_index++)
+            normal_image[pixel_index] = 0.5 * (aovs.normal[pixel_index] + vec3(1, 1, 1));
+        write_aov_image(aov_path_prefix + "_normal.ppm", normal_image);
+
+        double max_depth = 0;
+        for (double depth : aovs.depth)
+            if (depth != infinity)
+                max_depth = std::fmax(max_depth, depth);
+
+        std::vector<color> depth_image(aovs.depth.size());
+        for (size_t pixel_index = 0; pixel_index < aovs.depth.size(); pixel_index++) {
+            double level = (aovs.depth[pixel_index] == infinity || max_depth == 0)
+                ? 1.0 : aovs.depth[pixel_index] / max_depth;
+            depth_image[pixel_index] = color(level, level, level);
+        }
+        write_aov_image(aov_path_prefix + "_depth.ppm", depth_image);
+    }
+
+    // Raw linear P6 (no gamma): feature buffers are data, not display images.
+    void write_aov_image(const std::string& path, const std::vector<color>& data) const {
+        std::FILE* out = std::fopen(path.c_str(), "wb");
+        if (!out) {
+            std::clog << "Could not write AOV '" << path << "'\n";
+            return;
+        }
+
+        std::fprintf(out, "P6\n%d %d\n255\n", image_width, image_height);
+
+        std::vector<unsigned char> bytes(data.size() * 3);
+        for (size_t pixel_index = 0; pixel_index < data.size(); pixel_index++)
+            for (int channel = 0; channel < 3; channel++)
+                bytes[pixel_index * 3 + channel] = (unsigned char)(255.999 * interval(0, 1).clamp(data[pixel_index][channel]));
+
+        std::fwrite(bytes.data(), 1, bytes.size(), out);
+        std::fclose(out);
+
+        std::clog << "Wrote AOV '" << path << "'\n";
+    }
+
     point3 defocus_disk_sample() const {
         // Returns a random point in the camera defocus disk.
         vec3 p = random_in_unit_disk();
         return center + (p[0] * defocus_disk_u) + (p[1] * defocus_disk_v);
     }
 
-	color ray_color(const ray& r, uint16_t depth,const hittable& world) const {
-        // If we've exceeded the ray bounce limit, no more light is gathered.
-        if (depth <= 0)
-            return color(0, 0, 0);
+	template <bool with_lights>
+	color ray_color(const ray& r, uint16_t depth, const hittable& world) const {
+        RT_STAT(primary_rays);
+
+        hit_record first_rec;
+        bool first_hit = world.hit(r, interval(0.001, infinity), first_rec);
+        return ray_color_shaded<with_lights>(r, depth, world, first_hit, first_rec);
+	}
+
+    // Shades a path whose first intersection was already found — the packet tracer
+    // resolves primary visibility for 8 rays at once and continues each path here.
+    // Without lights the whole next-event block (two extra pdf evaluations and a
+    // branch per bounce) and the emitted() call compile out; scenes lit only by the
+    // background have no emissive materials to miss.
+	template <bool with_lights>
+	color ray_color_shaded(const ray& r, uint16_t depth, const hittable& world, bool first_hit, const hit_record& first_rec) const {
+        // Iterative bounce loop: radiance found along the path is accumulated directly,
+        // weighted by the product of the attenuations (throughput) picked up so far.
+        // This replaces the old recursion, which carried every path to full depth and
+        // paid stack traffic for bounces that no longer contributed anything visible.
+        ray current_ray = r;
+        color throughput(1, 1, 1);
+        color accumulated(0, 0, 0);
+
+        for (uint16_t bounce = 0; bounce < depth; bounce++) {
+            hit_record rec;
+            bool has_hit;
+
+            if (bounce == 0) {
+                rec = first_rec;
+                has_hit = first_hit;
+            }
+            else {
+                RT_STAT(secondary_rays);
+                has_hit = world.hit(current_ray, interval(0.001, infinity), rec);
+            }
+
+            // If the ray hits nothing, pick up the background color and stop
+            if (!has_hit) {
+                accumulated += throughput * background;
+                break;
+            }
+
+            if constexpr (with_lights)
+                accumulated += throughput * rec.mat->emitted(rec.u, rec.v, rec.p);
 
-		hit_record rec;
+            ray scattered;
+            color attenuation;
 
-        // If the ray hits nothing, return the background color
-        if (!world.hit(r, interval(0.001, infinity), rec))
-            return background;
+            if (!rec.mat->scatter(current_ray, rec, attenuation, scattered))
+                break;
 
-        ray scattered;
-        color attenuation;
-        color color_from_emission = rec.mat->emitted(rec.u, rec.v, rec.p);
+            bool sampled_light = false;
+            if constexpr (with_lights) {
+                // Specular materials report no density; their scattered ray is followed as-is.
+                double scatter_pdf = rec.mat->scattering_pdf(current_ray, rec, scattered);
 
-        if (!rec.mat->scatter(r, rec, attenuation, scattered))
-            return color_from_emission;
-        
-        color color_from_scatter = attenuation * ray_color(scattered, depth - 1, world);
-        
-        return color_from_emission + color_from_scatter;
+                if (scatter_pdf > 0) {
+                    // Next-event estimation as a one-sample mixture: half the directions come
+                    // from the light list, half from the material's own sample, and the
+                    // contribution is reweighted by the mixture density. For a lambertian the
+                    // attenuation is the albedo, so attenuation * scattering_pdf is the BRDF
+                    // times cosine and the estimator stays unbiased.
+                    vec3 direction = (random_double() < 0.5) ? lights->random(rec.p) : scattered.direction();
+                    ray candidate(rec.p, direction, current_ray.time());
 
-		vec3 unit_direction = unit_vector(r.direction());
+                    double mixture_pdf = 0.5 * lights->pdf_value(rec.p, direction)
+                                       + 0.5 * rec.mat->scattering_pdf(current_ray, rec, candidate);
+
+                    if (mixture_pdf <= 0)
+                        break;
+
+                    throughput = throughput * attenuation * (rec.mat->scattering_pdf(current_ray, rec, candidate) / mixture_pdf);
+                    current_ray = candidate;
+                    sampled_light = true;
+                }
+            }
+
+            if (!sampled_light) {
+                throughput = throughput * attenuation;
+                current_ray = scattered;
+            }
+
+            // Russian roulette: once a path has bounced a few times, terminate it with a
+            // probability tied to its remaining throughput and boost the survivors by the
+            // inverse, so dim paths stop early while the estimator stays unbiased.
+            if (bounce + 1 >= rr_min_bounces) {
+                double survive_probability = std::fmax(throughput.x(), std::fmax(throughput.y(), throughput.z()));
+                survive_probability = std::fmin(survive_probability, 0.95);
+
+                if (random_double() >= survive_probability)
+                    break;
+
+                throughput /= survive_probability;
+            }
+        }
 
-		// Using one value between 0 (white) and 1 (blue), we can get all rgb values between blue and white 
-		double a = 0.5 * (unit_direction.y() + 1.0);
-		return (1.0 - a) * color(1.0, 1.0, 1.0) + a * color(0.5, 0.7, 1.0);
+        return accumulated;
 	}
 };
 #endif // ! CAMERA_H
\ No newline at end of file
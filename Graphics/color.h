@@ -39,6 +39,14 @@
  */
 
 
+#include <cstdio>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
 using color = vec3;
 
 inline double linear_to_gamma(double linear_component)
@@ -49,7 +57,12 @@ inline double linear_to_gamma(double linear_component)
 	return 0;
 }
 
-void write_color(std::ostream& out, const color& pixel_color) {
+inline double luminance(const color& c) {
+	// Rec. 709 luma weights; used as the scalar proxy when estimating pixel variance.
+	return 0.2126 * c.x() + 0.7152 * c.y() + 0.0722 * c.z();
+}
+
+inline void color_to_bytes(const color& pixel_color, unsigned char* bytes) {
 	double r = pixel_color.x();
 	double g = pixel_color.y();
 	double b = pixel_color.z();
@@ -61,11 +74,35 @@ void write_color(std::ostream& out, const color& pixel_color) {
 
 	// Translate the [0,1] component values to the byte range [0,255].
 	static const interval intensity(0.000, 0.999);
-	int rbyte = (255.999 * intensity.clamp(r));
-	int gbyte = (255.999 * intensity.clamp(g));
-	int bbyte = (255.999 * intensity.clamp(b));
+	bytes[0] = (unsigned char)(255.999 * intensity.clamp(r));
+	bytes[1] = (unsigned char)(255.999 * intensity.clamp(g));
+	bytes[2] = (unsigned char)(255.999 * intensity.clamp(b));
+}
+
+void write_color(std::ostream& out, const color& pixel_color) {
+	unsigned char bytes[3];
+	color_to_bytes(pixel_color, bytes);
+
+	out << int(bytes[0]) << ' ' << int(bytes[1]) << ' ' << int(bytes[2]) << '\n';
+}
+
+inline void write_ppm_binary(std::FILE* out, const std::vector<color>& pixel_data, int width, int height) {
+	// Binary PPM (P6): the whole framebuffer is converted into one user-space byte
+	// buffer and shipped with a single fwrite. Formatting millions of channels as
+	// decimal text through iostreams takes measurable seconds per frame and triples
+	// the file size; this path avoids both.
+#ifdef _WIN32
+	_setmode(_fileno(out), _O_BINARY); // Stop the CRT from expanding \n in the pixel bytes
+#endif
+
+	std::fprintf(out, "P6\n%d %d\n255\n", width, height);
+
+	std::vector<unsigned char> bytes(size_t(width) * height * 3);
+	for (size_t i = 0; i < pixel_data.size(); i++)
+		color_to_bytes(pixel_data[i], &bytes[i * 3]);
 
-	out << rbyte << ' ' << gbyte << ' ' << bbyte << '\n';
+	std::fwrite(bytes.data(), 1, bytes.size(), out);
+	std::fflush(out);
 }
 
 #endif
\ No newline at end of file
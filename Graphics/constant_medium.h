@@ -5,59 +5,124 @@
 #include "material.h"
 #include "texture.h"
 
+/*
+ * Participating medium bounded by a hittable (smoke boxes, the final_scene mist).
+ *
+ * The boundary span is resolved with at most two boundary queries: the first hit's
+ * front_face bit tells whether the ray starts inside (an exit surface comes first),
+ * in which case the second query is skipped entirely. final_scene wraps the whole
+ * scene in a 5000-radius mist sphere, so nearly every ray takes that single-query
+ * path each bounce.
+ *
+ * Homogeneous media sample the scatter distance in closed form. Derived media with
+ * spatially varying density construct through the protected constructor with their
+ * peak density as the majorant and override density_at(); hit() then samples by
+ * ratio tracking (exponential jumps under the majorant, accepting real collisions
+ * with probability density/majorant), which needs no boundary hits inside the loop.
+ */
+
 class constant_medium : public hittable {
 public:
     constant_medium(shared_ptr<hittable> boundary, double density, shared_ptr<texture> tex)
-        : boundary(boundary), neg_inv_density(-1 / density),
+        : boundary(boundary), neg_inv_density(-1 / density), majorant(density),
         phase_function(make_shared<isotropic>(tex))
     {}
 
     constant_medium(shared_ptr<hittable> boundary, double density, const color& albedo)
-        : boundary(boundary), neg_inv_density(-1 / density),
+        : boundary(boundary), neg_inv_density(-1 / density), majorant(density),
         phase_function(make_shared<isotropic>(albedo))
     {}
 
     bool hit(const ray& r, interval ray_t, hit_record& rec) const override {
-        hit_record rec1, rec2;
-
-        if (!boundary->hit(r, interval::universe, rec1))
-            return false;
-
-        if (!boundary->hit(r, interval(rec1.t + 0.0001, infinity), rec2))
-            return false;
-
-        if (rec1.t < ray_t.min) rec1.t = ray_t.min;
-        if (rec2.t > ray_t.max) rec2.t = ray_t.max;
-
-        if (rec1.t >= rec2.t)
+        double t_entry, t_exit;
+        if (!boundary_span(r, ray_t, t_entry, t_exit))
             return false;
 
-        if (rec1.t < 0)
-            rec1.t = 0;
-
         auto ray_length = r.direction().length();
-        auto distance_inside_boundary = (rec2.t - rec1.t) * ray_length;
-        auto hit_distance = neg_inv_density * std::log(random_double());
-
-        if (hit_distance > distance_inside_boundary)
+        auto distance_inside_boundary = (t_exit - t_entry) * ray_length;
+
+        double hit_distance;
+        if (homogeneous) {
+            hit_distance = neg_inv_density * std::log(random_double());
+            if (hit_distance > distance_inside_boundary)
+                return false;
+        }
+        else if (!sample_majorant(r, t_entry, ray_length, distance_inside_boundary, hit_distance)) {
             return false;
+        }
 
-        rec.t = rec1.t + hit_distance / ray_length;
+        rec.t = t_entry + hit_distance / ray_length;
         rec.p = r.at(rec.t);
 
         rec.normal = vec3(1, 0, 0);
         rec.front_face = true;
-        rec.mat = phase_function;
+        rec.mat = phase_function.get();
 
         return true;
     }
 
     aabb bounding_box() const override { return boundary->bounding_box(); }
 
+protected:
+    // For derived media with varying density: majorant_density must bound density_at()
+    // from above everywhere inside the boundary, or collisions will be missed.
+    constant_medium(shared_ptr<hittable> boundary, double majorant_density, shared_ptr<texture> tex, bool varying)
+        : boundary(boundary), neg_inv_density(-1 / majorant_density), majorant(majorant_density),
+        phase_function(make_shared<isotropic>(tex)), homogeneous(!varying)
+    {}
+
+    virtual double density_at(const point3& p) const { return majorant; }
+
 private:
+    friend class scene_file;
+
     shared_ptr<hittable> boundary;
     double neg_inv_density;
+    double majorant;
     shared_ptr<material> phase_function;
-};
+    bool homogeneous = true;
+
+    // Resolve [t_entry, t_exit] of the ray's overlap with the boundary. A ray that
+    // starts inside meets an exit surface first (front_face false) and needs no
+    // second query.
+    bool boundary_span(const ray& r, interval ray_t, double& t_entry, double& t_exit) const {
+        hit_record rec1;
+        if (!boundary->hit(r, interval(ray_t.min, infinity), rec1))
+            return false;
 
-#endif
\ No newline at end of file
+        if (!rec1.front_face) {
+            t_entry = std::fmax(ray_t.min, 0);
+            t_exit = rec1.t;
+        }
+        else {
+            t_entry = rec1.t;
+
+            hit_record rec2;
+            if (!boundary->hit(r, interval(t_entry + 0.0001, infinity), rec2))
+                return false;
+            t_exit = rec2.t;
+        }
+
+        if (t_exit > ray_t.max) t_exit = ray_t.max;
+        return t_entry < t_exit;
+    }
+
+    // Ratio tracking against the majorant: exponential jumps sized by the majorant
+    // density, keeping a tentative collision with probability density/majorant. The
+    // loop touches only density_at(), never the boundary.
+    bool sample_majorant(const ray& r, double t_entry, double ray_length, double span, double& hit_distance) const {
+        double distance = 0;
+        for (;;) {
+            distance -= std::log(random_double()) / majorant;
+            if (distance > span)
+                return false;
+
+            point3 p = r.at(t_entry + distance / ray_length);
+            if (random_double() < density_at(p) / majorant) {
+                hit_distance = distance;
+                return true;
+            }
+        }
+    }
+};
+#endif
@@ -39,9 +39,13 @@ struct hit_record {
 public:
 	point3 p;
 	vec3 normal;
-	shared_ptr<material> mat;
+	// Non-owning: the scene (hittable_list / scene arenas) owns every material, so the
+	// hot path hands back a raw pointer instead of bumping a shared_ptr refcount
+	// (an atomic pair per hit) billions of times per frame.
+	const material* mat = nullptr;
 	double t;
 	double u, v; // Texture parameters
+	double uv_per_unit = 0; // Approximate uv-space length of one world unit on the surface, for texture filtering
 	bool front_face;
 
 	void set_face_normal(const ray& r, const vec3& outward_normal) {
@@ -54,11 +58,58 @@ public:
 	}
 };
 
+/*
+ * Ray packet: a bundle of up to 8 coherent rays traced together so acceleration
+ * structures can amortize their per-node work (SIMD slab tests) across the bundle.
+ * Each ray keeps its own shrinking search interval in closest[], so hit_packet calls
+ * compose: forwarding the same packet to several objects yields the nearest hit
+ * overall, exactly like chained scalar hit() calls.
+ */
+struct ray_packet {
+	ray rays[8];
+	hit_record recs[8];
+	bool hits[8] = {};
+	double closest[8];  // Per-ray upper search bound, shrinks as hits are found
+	double t_min = 0;
+	int count = 0;      // Active rays; trailing lanes are ignored
+
+	void init(int ray_count, interval ray_t) {
+		count = ray_count;
+		t_min = ray_t.min;
+		for (int i = 0; i < 8; i++) {
+			hits[i] = false;
+			closest[i] = ray_t.max;
+		}
+	}
+};
+
 class hittable {
 public:
 	virtual ~hittable() = default;
 	virtual bool hit(const ray& r, interval ray_t, hit_record& rec) const = 0;
 	virtual aabb bounding_box() const = 0;
+
+	// Trace a packet of coherent rays. The default just loops the scalar hit();
+	// acceleration structures override it with a shared SIMD traversal.
+	virtual void hit_packet(ray_packet& packet) const {
+		for (int i = 0; i < packet.count; i++) {
+			if (hit(packet.rays[i], interval(packet.t_min, packet.closest[i]), packet.recs[i])) {
+				packet.hits[i] = true;
+				packet.closest[i] = packet.recs[i].t;
+			}
+		}
+	}
+
+	// Sampling interface for next-event estimation: the probability density of reaching
+	// this object from origin along direction, and a random direction from origin toward
+	// the object. Only shapes usable as explicit lights (sphere, quad) implement these.
+	virtual double pdf_value(const point3& origin, const vec3& direction) const {
+		return 0.0;
+	}
+
+	virtual vec3 random(const point3& origin) const {
+		return vec3(1, 0, 0);
+	}
 };
 
 class translate : public hittable {
@@ -85,6 +136,9 @@ public:
 	aabb bounding_box() const override { return bbox; }
 
 private:
+	friend class scene_file;
+	friend class instance;
+
 	shared_ptr<hittable> hittable_object;
 	vec3 offset;
 	aabb bbox;
@@ -147,6 +201,9 @@ public:
 	aabb bounding_box() const override { return bbox; }
 
 private:
+	friend class scene_file;
+	friend class instance;
+
 	shared_ptr<hittable> hittable_object;
 	double sin_theta;
 	double cos_theta;
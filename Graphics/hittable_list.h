@@ -69,6 +69,28 @@ public:
 	}
 	aabb bounding_box() const override { return bbox; }
 
+	void hit_packet(ray_packet& packet) const override {
+		// Forwarding the packet child by child keeps each ray's shrinking interval, and
+		// lets children with a real packet path (bvh_flat) use it.
+		for (const shared_ptr<hittable>& hittable_object : hittables)
+			hittable_object->hit_packet(packet);
+	}
+
+	double pdf_value(const point3& origin, const vec3& direction) const override {
+		// Uniform mixture over the contained objects.
+		double weight = 1.0 / hittables.size();
+		double sum = 0.0;
+
+		for (const shared_ptr<hittable>& hittable_object : hittables)
+			sum += weight * hittable_object->pdf_value(origin, direction);
+
+		return sum;
+	}
+
+	vec3 random(const point3& origin) const override {
+		return hittables[random_int(0, int(hittables.size()) - 1)]->random(origin);
+	}
+
 private:
 	aabb bbox;
 };
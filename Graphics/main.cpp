@@ -1,394 +1,118 @@
 #include "helper.h"
 
-#include "bvh.h"
-#include "camera.h"
-#include "hittable.h"
-#include "hittable_list.h"
-#include "quad.h"
-#include "constant_medium.h"
-#include "sphere.h"
-#include "texture.h"
-#include "rtw_stb_image.h"
-
-void final_scene(int image_width, int samples_per_pixel, int max_depth) {
-    hittable_list boxes1;
-    auto ground = make_shared<lambertian>(color(0.48, 0.83, 0.53));
-
-    int boxes_per_side = 20;
-    for (int i = 0; i < boxes_per_side; i++) {
-        for (int j = 0; j < boxes_per_side; j++) {
-            auto w = 100.0;
-            auto x0 = -1000.0 + i * w;
-            auto z0 = -1000.0 + j * w;
-            auto y0 = 0.0;
-            auto x1 = x0 + w;
-            auto y1 = random_double(1, 101);
-            auto z1 = z0 + w;
-
-            boxes1.add(box(point3(x0, y0, z0), point3(x1, y1, z1), ground));
-        }
-    }
-
-    hittable_list world;
-
-    world.add(make_shared<bvh_node>(boxes1));
-
-    auto light = make_shared<diffuse_light>(color(7, 7, 7));
-    world.add(make_shared<quad>(point3(123, 554, 147), vec3(300, 0, 0), vec3(0, 0, 265), light));
-
-    auto center1 = point3(400, 400, 200);
-    auto center2 = center1 + vec3(30, 0, 0);
-    auto sphere_material = make_shared<lambertian>(color(0.7, 0.3, 0.1));
-    world.add(make_shared<sphere>(center1, center2, 50, sphere_material));
-
-    world.add(make_shared<sphere>(point3(260, 150, 45), 50, make_shared<dielectric>(1.5)));
-    world.add(make_shared<sphere>(point3(0, 150, 145), 50, make_shared<metal>(color(0.8, 0.8, 0.9), 1.0)));
-
-    auto boundary = make_shared<sphere>(point3(360, 150, 145), 70, make_shared<dielectric>(1.5));
-    world.add(boundary);
-    world.add(make_shared<constant_medium>(boundary, 0.2, color(0.2, 0.4, 0.9)));
-    boundary = make_shared<sphere>(point3(0, 0, 0), 5000, make_shared<dielectric>(1.5));
-    world.add(make_shared<constant_medium>(boundary, .0001, color(1, 1, 1)));
-
-    auto emat = make_shared<lambertian>(make_shared<image_texture>("earthmap.jpg"));
-    world.add(make_shared<sphere>(point3(400, 200, 400), 100, emat));
-    auto pertext = make_shared<noise_texture>(0.2);
-    world.add(make_shared<sphere>(point3(220, 280, 300), 80, make_shared<lambertian>(pertext)));
-
-    hittable_list boxes2;
-    auto white = make_shared<lambertian>(color(.73, .73, .73));
-    int ns = 1000;
-    for (int j = 0; j < ns; j++) {
-        boxes2.add(make_shared<sphere>(point3::random(interval(0, 165)), 10, white));
-    }
-
-    world.add(make_shared<translate>(make_shared<rotate_y>(make_shared<bvh_node>(boxes2), 15), vec3(-100, 270, 395)));
-
-    camera cam;
-
-    cam.aspect_ratio = 1.0;
-    cam.image_width = image_width;
-    cam.samples_per_pixel = samples_per_pixel;
-    cam.max_depth = max_depth;
-    cam.background = color(0, 0, 0);
-
-    cam.vfov = 40;
-    cam.lookfrom = point3(478, 278, -600);
-    cam.lookat = point3(278, 278, 0);
-    cam.vup = vec3(0, 1, 0);
-
-    cam.defocus_angle = 0;
-
-    cam.render(world);
+#include "scene_file.h"
+#include "scenes.h"
+
+#include <cstdlib>
+#include <cstring>
+
+// Scene construction lives in scenes.h (shared with the benchmark harness); each
+// function here just builds its setup and renders it.
+//
+// Distributed rendering splits one frame across machines through three modes, with
+// the farm scheduler acting as coordinator:
+//
+//     raytracer export <scene> <scene.rtsc>              (once, on any machine)
+//     raytracer worker <scene.rtsc> <index> <count> <out.part>   (one per node)
+//     raytracer merge <part...> > image.ppm              (once all workers finish)
+//
+// Each worker loads the scene from the binary file, renders its 1/count share of the
+// samples, and writes a partial accumulation buffer; merge sums the partials into the
+// final image. Sample shares keep every node's load even, so scaling tracks the node
+// count until scene build time dominates.
+
+static void render_setup(scene_setup setup) {
+    setup.cam.render(setup.world);
 }
 
-void cornell_smoke() {
-    hittable_list world;
-
-    auto red = make_shared<lambertian>(color(.65, .05, .05));
-    auto white = make_shared<lambertian>(color(.73, .73, .73));
-    auto green = make_shared<lambertian>(color(.12, .45, .15));
-    auto light = make_shared<diffuse_light>(color(7, 7, 7));
-
-    world.add(make_shared<quad>(point3(555, 0, 0), vec3(0, 555, 0), vec3(0, 0, 555), green));
-    world.add(make_shared<quad>(point3(0, 0, 0), vec3(0, 555, 0), vec3(0, 0, 555), red));
-    world.add(make_shared<quad>(point3(113, 554, 127), vec3(330, 0, 0), vec3(0, 0, 305), light));
-    world.add(make_shared<quad>(point3(0, 555, 0), vec3(555, 0, 0), vec3(0, 0, 555), white));
-    world.add(make_shared<quad>(point3(0, 0, 0), vec3(555, 0, 0), vec3(0, 0, 555), white));
-    world.add(make_shared<quad>(point3(0, 0, 555), vec3(555, 0, 0), vec3(0, 555, 0), white));
-
-    shared_ptr<hittable> box1 = box(point3(0, 0, 0), point3(165, 330, 165), white);
-    box1 = make_shared<rotate_y>(box1, 15);
-    box1 = make_shared<translate>(box1, vec3(265, 0, 295));
-
-    shared_ptr<hittable> box2 = box(point3(0, 0, 0), point3(165, 165, 165), white);
-    box2 = make_shared<rotate_y>(box2, -18);
-    box2 = make_shared<translate>(box2, vec3(130, 0, 65));
-
-    world.add(make_shared<constant_medium>(box1, 0.01, color(0, 0, 0)));
-    world.add(make_shared<constant_medium>(box2, 0.01, color(1, 1, 1)));
-
-    camera cam;
-
-    cam.aspect_ratio = 1.0;
-    cam.image_width = 600;
-    cam.samples_per_pixel = 200;
-    cam.max_depth = 50;
-    cam.background = color(0, 0, 0);
-
-    cam.vfov = 40;
-    cam.lookfrom = point3(278, 278, -800);
-    cam.lookat = point3(278, 278, 0);
-    cam.vup = vec3(0, 1, 0);
-
-    cam.defocus_angle = 0;
-
-    cam.render(world);
+static scene_setup build_scene(int scene_number) {
+    switch (scene_number) {
+        case 1: return build_bounding_spheres();
+        case 2: return build_checkered_spheres();
+        case 3: return build_earth();
+        case 4: return build_perlin_spheres();
+        case 5: return build_quads();
+        case 6: return build_simple_light();
+        case 7: return build_cornell_box();
+        case 8: return build_cornell_smoke();
+        case 9: return build_final_scene(1200, 4000, 40);
+        default: return build_final_scene(400, 250, 4);
+    }
 }
 
-void cornell_box() {
-    hittable_list world;
-
-    auto red = make_shared<lambertian>(color(.65, .05, .05));
-    auto white = make_shared<lambertian>(color(.73, .73, .73));
-    auto green = make_shared<lambertian>(color(.12, .45, .15));
-    auto light = make_shared<diffuse_light>(color(15, 15, 15));
-
-    world.add(make_shared<quad>(point3(555, 0, 0), vec3(0, 555, 0), vec3(0, 0, 555), green));
-    world.add(make_shared<quad>(point3(0, 0, 0), vec3(0, 555, 0), vec3(0, 0, 555), red));
-    world.add(make_shared<quad>(point3(343, 554, 332), vec3(-130, 0, 0), vec3(0, 0, -105), light));
-    world.add(make_shared<quad>(point3(0, 0, 0), vec3(555, 0, 0), vec3(0, 0, 555), white));
-    world.add(make_shared<quad>(point3(555, 555, 555), vec3(-555, 0, 0), vec3(0, 0, -555), white));
-    world.add(make_shared<quad>(point3(0, 0, 555), vec3(555, 0, 0), vec3(0, 555, 0), white));
-
-    shared_ptr<hittable> box1 = box(point3(0, 0, 0), point3(165, 330, 165), white);
-    box1 = make_shared<rotate_y>(box1, 15);
-    box1 = make_shared<translate>(box1, vec3(265, 0, 295));
-    world.add(box1);
-
-    shared_ptr<hittable> box2 = box(point3(0, 0, 0), point3(165, 165, 165), white);
-    box2 = make_shared<rotate_y>(box2, -18);
-    box2 = make_shared<translate>(box2, vec3(130, 0, 65));
-    world.add(box2);
-
-    world.add(box(point3(130, 0, 65), point3(295, 165, 230), white));
-    world.add(box(point3(265, 0, 295), point3(430, 330, 460), white));
-
-    camera cam;
-
-    cam.aspect_ratio = 1.0;
-    cam.image_width = 600;
-    cam.samples_per_pixel = 200;
-    cam.max_depth = 50;
-    cam.background = color(0, 0, 0);
-
-    cam.vfov = 40;
-    cam.lookfrom = point3(278, 278, -800);
-    cam.lookat = point3(278, 278, 0);
-    cam.vup = vec3(0, 1, 0);
-
-    cam.defocus_angle = 0;
-
-    cam.render(world);
+static int export_scene(int scene_number, const char* path) {
+    scene_setup setup = build_scene(scene_number);
+    return scene_file::save(path, setup.world, setup.cam) ? 0 : 1;
 }
 
-void simple_light() {
+static int run_worker(const char* scene_path, int worker_index, int worker_count, const char* partial_path) {
+    scene arena;
     hittable_list world;
-
-    auto pertext = make_shared<noise_texture>(4);
-    world.add(make_shared<sphere>(point3(0, -1000, 0), 1000, make_shared<lambertian>(pertext)));
-    world.add(make_shared<sphere>(point3(0, 2, 0), 2, make_shared<lambertian>(pertext)));
-
-    auto difflight = make_shared<diffuse_light>(color(4, 4, 4));
-    world.add(make_shared<sphere>(point3(0, 7, 0), 2, difflight));
-    world.add(make_shared<quad>(point3(3, 1, -2), vec3(2, 0, 0), vec3(0, 2, 0), difflight));
-
     camera cam;
 
-    cam.aspect_ratio = 16.0 / 9.0;
-    cam.image_width = 400;
-    cam.samples_per_pixel = 100;
-    cam.max_depth = 50;
-    cam.background = color(0, 0, 0);
-
-    cam.vfov = 20;
-    cam.lookfrom = point3(26, 3, 6);
-    cam.lookat = point3(0, 2, 0);
-    cam.vup = vec3(0, 1, 0);
-
-    cam.defocus_angle = 0;
+    if (!scene_file::load(scene_path, arena, world, cam))
+        return 1;
 
-    cam.render(world);
+    return cam.render_partial(world, worker_index, worker_count, partial_path) ? 0 : 1;
 }
 
-void quads() {
+// Turntable animation: the scene and its BVH are built once, then every frame just
+// swings lookfrom around lookat before rendering. Frame N's file write overlaps frame
+// N+1's sampling inside render_sequence.
+static int run_animation(const char* scene_path, int frame_count, const char* path_pattern) {
+    scene arena;
     hittable_list world;
-
-    // Materials
-    auto left_red = make_shared<lambertian>(color(1.0, 0.2, 0.2));
-    auto back_green = make_shared<lambertian>(color(0.2, 1.0, 0.2));
-    auto right_blue = make_shared<lambertian>(color(0.2, 0.2, 1.0));
-    auto upper_orange = make_shared<lambertian>(color(1.0, 0.5, 0.0));
-    auto lower_teal = make_shared<lambertian>(color(0.2, 0.8, 0.8));
-
-    // Quads
-    world.add(make_shared<quad>(point3(-3, -2, 5), vec3(0, 0, -4), vec3(0, 4, 0), left_red));
-    world.add(make_shared<quad>(point3(-2, -2, 0), vec3(4, 0, 0), vec3(0, 4, 0), back_green));
-    world.add(make_shared<quad>(point3(3, -2, 1), vec3(0, 0, 4), vec3(0, 4, 0), right_blue));
-    world.add(make_shared<quad>(point3(-2, 3, 1), vec3(4, 0, 0), vec3(0, 0, 4), upper_orange));
-    world.add(make_shared<quad>(point3(-2, -3, 5), vec3(4, 0, 0), vec3(0, 0, -4), lower_teal));
-
     camera cam;
 
-    cam.aspect_ratio = 1.0;
-    cam.image_width = 400;
-    cam.samples_per_pixel = 100;
-    cam.max_depth = 50;
-    cam.background = color(0.70, 0.80, 1.00);
+    if (!scene_file::load(scene_path, arena, world, cam))
+        return 1;
 
-    cam.vfov = 80;
-    cam.lookfrom = point3(0, 0, 9);
-    cam.lookat = point3(0, 0, 0);
-    cam.vup = vec3(0, 1, 0);
+    point3 pivot = cam.lookat;
+    vec3 start_offset = cam.lookfrom - pivot;
 
-    cam.defocus_angle = 0;
+    cam.render_sequence(world, frame_count, path_pattern, [&](int frame, camera& frame_cam) {
+        double angle = 2 * pi * frame / frame_count;
+        double sin_a = std::sin(angle), cos_a = std::cos(angle);
 
-    cam.render(world);
-}
-
-void perlin_spheres() {
-    hittable_list world;
+        // Rotate the starting offset about the vertical axis through the pivot.
+        frame_cam.lookfrom = pivot + vec3(
+            cos_a * start_offset.x() + sin_a * start_offset.z(),
+            start_offset.y(),
+            -sin_a * start_offset.x() + cos_a * start_offset.z());
+    });
 
-    auto pertext = make_shared<noise_texture>(4);
-    world.add(make_shared<sphere>(point3(0, -1000, 0), 1000, make_shared<lambertian>(pertext)));
-    world.add(make_shared<sphere>(point3(0, 2, 0), 2, make_shared<lambertian>(pertext)));
-
-    camera cam;
-
-    cam.aspect_ratio = 16.0 / 9.0;
-    cam.image_width = 400;
-    cam.samples_per_pixel = 100;
-    cam.max_depth = 50;
-    cam.background = color(0.70, 0.80, 1.00);
-
-    cam.vfov = 20;
-    cam.lookfrom = point3(13, 2, 3);
-    cam.lookat = point3(0, 0, 0);
-    cam.vup = vec3(0, 1, 0);
-
-    cam.defocus_angle = 0;
-
-    cam.render(world);
+    return 0;
 }
 
-void earth() {
-    auto earth_texture = make_shared<image_texture>("earthmap.jpg");
-    auto earth_surface = make_shared<lambertian>(earth_texture);
-    auto globe = make_shared<sphere>(point3(0, 0, 0), 2, earth_surface);
-
+static int run_merge(char** partial_paths, int partial_count) {
+    std::vector<std::string> paths(partial_paths, partial_paths + partial_count);
     camera cam;
-
-    cam.aspect_ratio = 16.0 / 9.0;
-    cam.image_width = 400;
-    cam.samples_per_pixel = 100;
-    cam.max_depth = 50;
-    cam.background = color(0.70, 0.80, 1.00);
-
-    cam.vfov = 20;
-    cam.lookfrom = point3(0, 0, 12);
-    cam.lookat = point3(0, 0, 0);
-    cam.vup = vec3(0, 1, 0);
-
-    cam.defocus_angle = 0;
-
-    cam.render(hittable_list(globe));
+    return cam.merge_partials(paths, stdout) ? 0 : 1;
 }
 
-void bounding_spheres() {
-	hittable_list world;
+int main(int argc, char* argv[]) {
+    if (argc >= 4 && std::strcmp(argv[1], "export") == 0)
+        return export_scene(std::atoi(argv[2]), argv[3]);
 
-    auto checker = make_shared<checker_texture>(0.32, color(0.2, 0.3, 0.1), color(0.9, 0.9, 0.9));
-    world.add(make_shared<sphere>(point3(0, -1000, 0), 1000, make_shared<lambertian>(checker)));
+    if (argc >= 6 && std::strcmp(argv[1], "worker") == 0)
+        return run_worker(argv[2], std::atoi(argv[3]), std::atoi(argv[4]), argv[5]);
 
-    for (int a = -11; a < 11; a++) {
-        for (int b = -11; b < 11; b++) {
-            auto choose_mat = random_double();
-            point3 center(a + 0.9 * random_double(), 0.2, b + 0.9 * random_double());
+    if (argc >= 5 && std::strcmp(argv[1], "animate") == 0)
+        return run_animation(argv[2], std::atoi(argv[3]), argv[4]);
 
-            if ((center - point3(4, 0.2, 0)).length() > 0.9) {
-                shared_ptr<material> sphere_material;
+    if (argc >= 3 && std::strcmp(argv[1], "merge") == 0)
+        return run_merge(argv + 2, argc - 2);
 
-                if (choose_mat < 0.8) {
-                    // diffuse
-                    auto albedo = color::random() * color::random();
-                    sphere_material = make_shared<lambertian>(albedo);
-                    auto center2 = center + vec3(0, random_double(0, .5), 0);
-                    world.add(make_shared<sphere>(center, center2, 0.2, sphere_material));
-                }
-                else if (choose_mat < 0.95) {
-                    // metal
-                    auto albedo = color::random(interval(0.5,1));
-                    auto fuzz = random_double(0, 0.5);
-                    sphere_material = make_shared<metal>(albedo, fuzz);
-                    world.add(make_shared<sphere>(center, 0.2, sphere_material));
-                }
-                else {
-                    // glass
-                    sphere_material = make_shared<dielectric>(1.5);
-                    world.add(make_shared<sphere>(center, 0.2, sphere_material));
-                }
-            }
-        }
+    if (argc > 1) {
+        std::fprintf(stderr,
+            "Usage: %s                                        render the built-in scene\n"
+            "       %s export <scene> <scene.rtsc>            save a built-in scene (1-9)\n"
+            "       %s worker <scene.rtsc> <index> <count> <out.part>\n"
+            "       %s merge <part...>                        merged image on stdout\n"
+            "       %s animate <scene.rtsc> <frames> <pattern>   turntable frames (pattern: frame_%%04d.ppm)\n",
+            argv[0], argv[0], argv[0], argv[0], argv[0]);
+        return 1;
     }
 
-    auto material1 = make_shared<dielectric>(1.5);
-    world.add(make_shared<sphere>(point3(0, 1, 0), 1.0, material1));
-
-    auto material2 = make_shared<lambertian>(color(0.4, 0.2, 0.1));
-    world.add(make_shared<sphere>(point3(-4, 1, 0), 1.0, material2));
-
-    auto material3 = make_shared<metal>(color(0.7, 0.6, 0.5), 0.0);
-    world.add(make_shared<sphere>(point3(4, 1, 0), 1.0, material3));
-
-    // Create the BVH for performance
-    world = hittable_list(make_shared<bvh_node>(world));
-
-    camera cam;
-
-    cam.aspect_ratio = 16.0 / 9.0;
-    cam.image_width = 1200;
-    cam.samples_per_pixel = 500;
-    cam.max_depth = 50;
-    cam.background = color(0.70, 0.80, 1.00);
-
-    cam.vfov = 20;
-    cam.lookfrom = point3(13, 2, 3);
-    cam.lookat = point3(0, 0, 0);
-    cam.vup = vec3(0, 1, 0);
-
-    cam.defocus_angle = 0.6;
-    cam.focus_dist = 10.0;
-
-    cam.render(world);
-}
-
-void checkered_spheres() {
-    hittable_list world;
-
-    auto checker = make_shared<checker_texture>(0.32, color(0.2, 0.3, 0.1), color(0.9, 0.9, 0.9));
-
-    world.add(make_shared<sphere>(point3(0, -10, 0), 10, make_shared<lambertian>(checker)));
-    world.add(make_shared<sphere>(point3(0, 10, 0), 10, make_shared<lambertian>(checker)));
-
-    camera cam;
-
-    cam.aspect_ratio = 16.0 / 9.0;
-    cam.image_width = 400;
-    cam.samples_per_pixel = 100;
-    cam.max_depth = 50;
-    cam.background = color(0.70, 0.80, 1.00);
-
-    cam.vfov = 20;
-    cam.lookfrom = point3(13, 2, 3);
-    cam.lookat = point3(0, 0, 0);
-    cam.vup = vec3(0, 1, 0);
-
-    cam.defocus_angle = 0;
-
-    cam.render(world);
+    render_setup(build_scene(9));
 }
-
-int main() {
-    switch (9) {
-        case 1: bounding_spheres(); break;
-        case 2: checkered_spheres(); break;
-        case 3: earth(); break;
-        case 4: perlin_spheres(); break;
-        case 5: quads(); break;
-        case 6: simple_light(); break;
-        case 7: cornell_box(); break;
-        case 8: cornell_smoke();      break;
-        case 9:  final_scene(1200, 4000, 40); break;
-        default: final_scene(400, 250, 4); break;
-    }
-}
\ No newline at end of file
@@ -2,8 +2,16 @@
 #define MATERIAL_H
 
 #include "hittable.h"
+#include "render_stats.h"
+#include "onb.h"
 #include "texture.h"
 
+// uv-space width of the ray's footprint at the hit: cross-section width at the hit
+// distance, converted through the surface's uv density. 0 when either is unknown.
+inline double texture_footprint(const ray& r_in, const hit_record& rec) {
+	return r_in.spread() * (rec.p - r_in.origin()).length() * rec.uv_per_unit;
+}
+
 class material {
 public:
 	virtual ~material() = default;
@@ -17,6 +25,20 @@ public:
 	) const {
 		return false;
 	}
+
+	// Density with which scatter() would have generated the given outgoing ray. Returns 0
+	// for specular materials (metal, dielectric), which the renderer treats as
+	// non-importance-sampleable: their scattered ray is followed as-is.
+	virtual double scattering_pdf(const ray& r_in, const hit_record& rec, const ray& scattered) const {
+		return 0;
+	}
+
+	// Base surface color at a hit point, for the camera's feature (AOV) buffers: the
+	// noise-free tint a denoiser should treat as this surface's appearance. White for
+	// materials without a meaningful one (dielectric).
+	virtual color base_color(double u, double v, const point3& p) const {
+		return color(1, 1, 1);
+	}
 };
 
 class lambertian : public material {
@@ -25,18 +47,35 @@ public:
 	lambertian(shared_ptr<texture> tex) : tex(tex) {};
 
 	bool scatter(const ray& r_in, const hit_record& rec, color& attenuation, ray& scattered) const override {
+		RT_STAT(scatter_lambertian);
+
+		// normal + uniform-unit-vector draws cosine-weighted directions, and with the
+		// analytic sphere sampler the whole draw is fixed-cost; measured cheaper than
+		// building an onb and transforming random_cosine_direction (no basis to build).
 		vec3 scatter_direction = rec.normal + random_unit_vector();
 
-		// normal + random_unit_vector could be opposites and the resultant would be 0, in this case we will discard the random_unit_vector
+		// The two could still be near-opposites and sum to ~zero; fall back to the normal.
 		if (scatter_direction.near_zero())
 			scatter_direction = rec.normal;
 
 		scattered = ray(rec.p, scatter_direction, r_in.time());
-		attenuation = tex->value(rec.u, rec.v, rec.p);
+		attenuation = tex->value(rec.u, rec.v, rec.p, texture_footprint(r_in, rec));
 		return true;
 	}
 
+	double scattering_pdf(const ray& r_in, const hit_record& rec, const ray& scattered) const override {
+		// scatter() draws cosine-weighted directions: pdf = cos(theta) / pi
+		double cos_theta = dot(rec.normal, unit_vector(scattered.direction()));
+		return cos_theta < 0 ? 0 : cos_theta / pi;
+	}
+
+	color base_color(double u, double v, const point3& p) const override {
+		return tex->value(u, v, p);
+	}
+
 private:
+	friend class scene_file;
+
 	shared_ptr<texture> tex;
 };
 
@@ -46,6 +85,8 @@ public:
 	metal(const color& albedo, double fuzz) : albedo(albedo), fuzz(fuzz < 1 ? fuzz : 1) {}
 
 	bool scatter(const ray& r_in, const hit_record& rec, color& attenuation, ray& scattered) const override {
+		RT_STAT(scatter_metal);
+
 		vec3 reflected = reflect(r_in.direction(), rec.normal);
 		reflected = unit_vector(reflected) + (fuzz * random_unit_vector());
 		scattered = ray(rec.p, reflected, r_in.time());
@@ -54,7 +95,13 @@ public:
 		return (dot(scattered.direction(), rec.normal) > 0);
 	}
 
+	color base_color(double u, double v, const point3& p) const override {
+		return albedo;
+	}
+
 private:
+	friend class scene_file;
+
 	// How much the reflection is perfect or not
 	color albedo;
 
@@ -67,6 +114,8 @@ public:
 	dielectric(double refraction_index) : refraction_index(refraction_index) {}
 
 	bool scatter(const ray& r_in, const hit_record& rec, color& attenuation, ray& scattered) const override {
+		RT_STAT(scatter_dielectric);
+
 		attenuation = color(1.0, 1.0, 1.0);
 		double ri = rec.front_face ? (1.0 / refraction_index) : refraction_index;
 		
@@ -88,6 +137,8 @@ public:
 	}
 
 private:
+	friend class scene_file;
+
 	// Refractive index in vacuum or air, or the ratio of the material's refractive index over the refractive index of the enclosing media
 	double refraction_index;
 
@@ -108,7 +159,13 @@ public:
 		return tex->value(u, v, p);
 	}
 
+	color base_color(double u, double v, const point3& p) const override {
+		return tex->value(u, v, p);
+	}
+
 private:
+	friend class scene_file;
+
 	shared_ptr<texture> tex;
 };
 
@@ -119,12 +176,24 @@ public:
 
 	bool scatter(const ray& r_in, const hit_record& rec, color& attenuation, ray& scattered)
 		const override {
+		RT_STAT(scatter_isotropic);
+
 		scattered = ray(rec.p, random_unit_vector(), r_in.time());
-		attenuation = tex->value(rec.u, rec.v, rec.p);
+		attenuation = tex->value(rec.u, rec.v, rec.p, texture_footprint(r_in, rec));
 		return true;
 	}
 
+	double scattering_pdf(const ray& r_in, const hit_record& rec, const ray& scattered) const override {
+		return 1 / (4 * pi); // Uniform over the sphere of directions
+	}
+
+	color base_color(double u, double v, const point3& p) const override {
+		return tex->value(u, v, p);
+	}
+
 private:
+	friend class scene_file;
+
 	shared_ptr<texture> tex;
 };
 #endif
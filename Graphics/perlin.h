@@ -3,6 +3,10 @@
 
 #include "helper.h"
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
 /*
  * Perlin Noise Generator
  * ----------------------
@@ -17,25 +21,24 @@
  * Key Features:
  * -------------
  * - `noise(point3 p)`: Returns a smooth noise value in [0, 1) for input 3D point `p`.
- * - Uses 3D lattice of pseudo-random values and interpolates via `trilinear_interp()`.
+ * - Uses 3D lattice of pseudo-random gradients and interpolates their dot products.
  * - Applies Hermitian cubic smoothing (u = u*u*(3-2u)) to reduce visual artifacts.
  * - Repeatable via fixed-size permutation tables (perm_x, perm_y, perm_z).
  *
- * Interpolation Details:
- * ----------------------
- * - Computes noise contribution from the 8 corners of a surrounding cube.
- * - Interpolates using weights derived from fractional part of `p`.
- * - Hermitian smoothing refines interpolation to reduce grid artifacts (e.g., Mach bands).
+ * Performance:
+ * ------------
+ * - Gradients are stored as structure-of-arrays so the 8 corner dot products of one
+ *   cell evaluate four at a time with AVX2 (scalar loop otherwise), feeding a plain
+ *   trilinear blend of the results.
+ * - turb() is a fused kernel: doubling the sample point each octave doubles the
+ *   lattice coordinate exactly (floor(2(i+u)) = 2i + [u >= 1/2]), so the floor and
+ *   integer split are computed once and the remaining octaves derive their cell
+ *   indices with two integer ops per axis instead of re-flooring seven times.
  *
  * Usage:
  * ------
  * perlin noise_gen;
  * double val = noise_gen.noise(point3(x, y, z));
- *
- * Notes:
- * ------
- * - Efficient for real-time procedural texture generation.
- * - Higher-quality variations can extend to gradient noise or turbulence.
  */
 
 
@@ -44,7 +47,10 @@ class perlin {
 public:
 	perlin() {
 		for (int i = 0; i < point_count; i++) {
-			randvec[i] = unit_vector(vec3::random(interval(-1, 1)));
+			vec3 gradient = unit_vector(vec3::random(interval(-1, 1)));
+			grad_x[i] = gradient.x();
+			grad_y[i] = gradient.y();
+			grad_z[i] = gradient.z();
 		}
 
 		perlin_generate_perm(perm_x);
@@ -53,41 +59,49 @@ public:
 	}
 
 	double noise(const point3& p) const {
-		// Linear interpolation to smooth randomness
 		double u = p.x() - std::floor(p.x());
 		double v = p.y() - std::floor(p.y());
 		double w = p.z() - std::floor(p.z());
 
-		auto i = int(std::floor(p.x())) & 255;
-		auto j = int(std::floor(p.y())) & 255;
-		auto k = int(std::floor(p.z())) & 255;
-		vec3 c[2][2][2];
-
-		for (int di = 0; di < 2; di++)
-			for (int dj = 0; dj < 2; dj++)
-				for (int dk = 0; dk < 2; dk++)
-					c[di][dj][dk] = randvec[perm_x[(i + di) & 255] ^ perm_y[(j + dj) & 255] ^ perm_z[(k + dk) & 255]];
+		auto i = int(std::floor(p.x()));
+		auto j = int(std::floor(p.y()));
+		auto k = int(std::floor(p.z()));
 
-		return perlin_interp(c, u, v, w);
+		return eval_cell(i, j, k, u, v, w);
 	}
 
 	double turb(const point3& p, int depth) const {
-		auto accum = 0.0;
-		auto temp_p = p;
-		auto weight = 1.0;
+		double u = p.x() - std::floor(p.x());
+		double v = p.y() - std::floor(p.y());
+		double w = p.z() - std::floor(p.z());
+
+		auto i = int(std::floor(p.x()));
+		auto j = int(std::floor(p.y()));
+		auto k = int(std::floor(p.z()));
+
+		double accum = 0.0;
+		double weight = 1.0;
+
+		for (int octave = 0; ; octave++) {
+			accum += weight * eval_cell(i, j, k, u, v, w);
+			if (octave + 1 >= depth)
+				break;
 
-		for (int i = 0; i < depth; i++) {
-			accum += weight * noise(temp_p);
+			// Doubling the point doubles the cell coordinate exactly:
+			// floor(2(i + u)) = 2i + [u >= 1/2], so the next octave needs no floor.
 			weight *= 0.5;
-			temp_p *= 2;
+			int carry_u = u >= 0.5, carry_v = v >= 0.5, carry_w = w >= 0.5;
+			i = 2 * i + carry_u;  u = 2 * u - carry_u;
+			j = 2 * j + carry_v;  v = 2 * v - carry_v;
+			k = 2 * k + carry_w;  w = 2 * w - carry_w;
 		}
 
 		return std::fabs(accum);
 	}
 private:
 	static const int point_count = 256;
-	vec3 randvec[point_count];
-	double randfloat[point_count];
+	// Gradient components kept as separate arrays so corner gathers feed SIMD lanes.
+	double grad_x[point_count], grad_y[point_count], grad_z[point_count];
 	int perm_x[point_count], perm_y[point_count], perm_z[point_count];
 
 	static void perlin_generate_perm(int* p) {
@@ -106,20 +120,61 @@ private:
 		}
 	}
 
-	static double perlin_interp(const vec3 c[2][2][2], double u, double v, double w) {
-		auto uu = u * u * (3 - 2 * u);
-		auto vv = v * v * (3 - 2 * v);
-		auto ww = w * w * (3 - 2 * w);
-		auto accum = 0.0;
+	// Noise value within the cell at lattice coordinate (i, j, k) with fractional
+	// position (u, v, w): the 8 corner gradient dot products blended trilinearly with
+	// Hermite-smoothed weights. Corner order is di*4 + dj*2 + dk. The six permutation
+	// entries are looked up once and XOR-combined per corner, instead of three table
+	// reads per corner.
+	double eval_cell(int i, int j, int k, double u, double v, double w) const {
+		int px0 = perm_x[i & 255], px1 = perm_x[(i + 1) & 255];
+		int py0 = perm_y[j & 255], py1 = perm_y[(j + 1) & 255];
+		int pz0 = perm_z[k & 255], pz1 = perm_z[(k + 1) & 255];
+
+		alignas(32) double d[8];
+#if defined(__AVX2__)
+		// Gather the 8 corner gradients straight from the SoA tables and do four dot
+		// products per register; the two halves differ only in the u offset.
+		__m128i index0 = _mm_set_epi32(px0 ^ py1 ^ pz1, px0 ^ py1 ^ pz0, px0 ^ py0 ^ pz1, px0 ^ py0 ^ pz0);
+		__m128i index1 = _mm_set_epi32(px1 ^ py1 ^ pz1, px1 ^ py1 ^ pz0, px1 ^ py0 ^ pz1, px1 ^ py0 ^ pz0);
+
+		__m256d dv = _mm256_set_pd(v - 1, v - 1, v, v);    // dj = 0,0,1,1 (low to high)
+		__m256d dw = _mm256_set_pd(w - 1, w, w - 1, w);    // dk = 0,1,0,1
+
+		__m256d dots0 = _mm256_add_pd(
+			_mm256_mul_pd(_mm256_i32gather_pd(grad_x, index0, 8), _mm256_set1_pd(u)),
+			_mm256_add_pd(_mm256_mul_pd(_mm256_i32gather_pd(grad_y, index0, 8), dv),
+			              _mm256_mul_pd(_mm256_i32gather_pd(grad_z, index0, 8), dw)));
+		__m256d dots1 = _mm256_add_pd(
+			_mm256_mul_pd(_mm256_i32gather_pd(grad_x, index1, 8), _mm256_set1_pd(u - 1)),
+			_mm256_add_pd(_mm256_mul_pd(_mm256_i32gather_pd(grad_y, index1, 8), dv),
+			              _mm256_mul_pd(_mm256_i32gather_pd(grad_z, index1, 8), dw)));
+
+		_mm256_store_pd(d, dots0);
+		_mm256_store_pd(d + 4, dots1);
+#else
+		int index[8] = {
+			px0 ^ py0 ^ pz0, px0 ^ py0 ^ pz1, px0 ^ py1 ^ pz0, px0 ^ py1 ^ pz1,
+			px1 ^ py0 ^ pz0, px1 ^ py0 ^ pz1, px1 ^ py1 ^ pz0, px1 ^ py1 ^ pz1,
+		};
+		for (int corner = 0; corner < 8; corner++) {
+			int di = corner >> 2, dj = (corner >> 1) & 1, dk = corner & 1;
+			d[corner] = grad_x[index[corner]] * (u - di) + grad_y[index[corner]] * (v - dj) + grad_z[index[corner]] * (w - dk);
+		}
+#endif
+
+		double uu = u * u * (3 - 2 * u);
+		double vv = v * v * (3 - 2 * v);
+		double ww = w * w * (3 - 2 * w);
+
+		double e00 = d[0] + ww * (d[1] - d[0]);
+		double e01 = d[2] + ww * (d[3] - d[2]);
+		double e10 = d[4] + ww * (d[5] - d[4]);
+		double e11 = d[6] + ww * (d[7] - d[6]);
 
-		for (int i = 0; i < 2; i++)
-			for (int j = 0; j < 2; j++)
-				for (int k = 0; k < 2; k++) {
-					vec3 weight_v(u - i, v - j, w - k);
-					accum += (i * uu + (1 - i) * (1 - uu)) * (j * vv + (1 - j) * (1 - vv)) * (k * ww + (1 - k) * (1 - ww)) * dot(c[i][j][k], weight_v);
-				}
+		double f0 = e00 + vv * (e01 - e00);
+		double f1 = e10 + vv * (e11 - e10);
 
-		return accum;
+		return f0 + uu * (f1 - f0);
 	}
 };
 #endif
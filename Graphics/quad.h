@@ -12,6 +12,7 @@ public:
 		normal = unit_vector(n);
 		D = dot(normal, Q);
 		w = n / dot(n, n);
+		area = n.length();
 
 		set_bounding_box();
 	}
@@ -48,7 +49,7 @@ public:
 
 		rec.t = t;
 		rec.p = intersection;
-		rec.mat = mat;
+		rec.mat = mat.get();
 		rec.set_face_normal(r, normal);
 
 		return true;
@@ -64,10 +65,32 @@ public:
 
 		rec.u = a;
 		rec.v = b;
+		rec.uv_per_unit = 2 / (u.length() + v.length()); // u and v each span 1 over an edge length
 		return true;
 	}
 
+	double pdf_value(const point3& origin, const vec3& direction) const override {
+		// Converts the uniform-over-area density 1/area into a density over directions
+		// as seen from origin, via the distance and the angle to the quad plane.
+		hit_record rec;
+		if (!this->hit(ray(origin, direction), interval(0.001, infinity), rec))
+			return 0;
+
+		double distance_squared = rec.t * rec.t * direction.length_squared();
+		double cosine = std::fabs(dot(direction, rec.normal) / direction.length());
+
+		return distance_squared / (cosine * area);
+	}
+
+	vec3 random(const point3& origin) const override {
+		point3 p = Q + (random_double() * u) + (random_double() * v);
+		return p - origin;
+	}
+
 private:
+	friend class scene_file;
+	friend class instance;
+
 	point3 Q;
 	vec3 u, v;
 	vec3 w;
@@ -75,6 +98,7 @@ private:
 	aabb bbox;
 	vec3 normal;
 	double D;
+	double area;
 };
 
 
@@ -7,22 +7,40 @@ class ray {
 public:
 	ray() {}
 
-	ray(const point3& origin, const vec3& direction, double time) : orig(origin), dir(direction), tm(time) {}
+	ray(const point3& origin, const vec3& direction, real time) : orig(origin), dir(direction), tm(time) {
+		// Cached once here: BVH traversal tests the same ray against dozens of boxes,
+		// and each slab test only needs multiplies when the reciprocal is precomputed.
+		for (int axis = 0; axis < 3; axis++) {
+			inv_dir[axis] = real(1) / dir[axis]; // Infinity when dir[axis] == 0, which the slab test handles
+			dir_neg[axis] = dir[axis] < 0;
+		}
+	}
 
 	ray(const point3& origin, const vec3& direction) : ray(origin, direction, 0) {}
 
 	const point3& origin() const { return orig; }
 	const vec3& direction() const { return dir; }
+	const vec3& inverse_direction() const { return inv_dir; }
+	bool direction_is_negative(int axis) const { return dir_neg[axis]; }
+
+	// Approximate growth of the ray's cross section, as width per world unit traveled.
+	// The camera sets it to the pixel footprint on primary rays so textures can pick a
+	// filter width; 0 (the default for scattered rays) means "footprint unknown".
+	real spread() const { return spr; }
+	void set_spread(real spread) { spr = spread; }
 
-	point3 at(double t) const {
+	point3 at(real t) const {
 		return orig + t * dir;
 	}
 
-	double time() const { return tm; }
+	real time() const { return tm; }
 
 private:
 	point3 orig;
 	vec3 dir;
-	double tm;
+	vec3 inv_dir;
+	real tm;
+	real spr = 0;
+	bool dir_neg[3];
 };
 #endif // !RAY_H
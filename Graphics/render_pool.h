@@ -0,0 +1,146 @@
+#ifndef RENDER_POOL_H
+#define RENDER_POOL_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#endif
+
+/*
+ * Render Pool (persistent worker threads)
+ * ---------------------------------------
+ * A fixed set of worker threads created once and reused for every render job, instead
+ * of spawning and joining fresh std::threads per frame. For a single still image the
+ * difference is noise, but a multi-frame batch (animation, progressive passes) pays
+ * thread creation, stack allocation and scheduler warm-up on every frame otherwise.
+ *
+ * Model:
+ * ------
+ * - `run(job)` wakes every worker, calls `job(worker_index)` once on each, and blocks
+ *   until all calls return. Work distribution (e.g. an atomic tile ticket) lives in
+ *   the job itself, so the pool stays oblivious to what is being rendered.
+ * - Workers sleep on a condition variable between jobs; a generation counter tells
+ *   them a new job has been posted.
+ * - `shared_render_pool()` returns a process-wide pool sized to the hardware thread
+ *   count, built lazily on first use and torn down at exit.
+ *
+ * Usage:
+ * ------
+ * shared_render_pool().run([&](int worker) {
+ *     for (size_t i = ticket.fetch_add(1); i < tiles.size(); i = ticket.fetch_add(1))
+ *         render_tile(tiles[i]);
+ * });
+ */
+
+class render_pool {
+public:
+	explicit render_pool(int thread_count = 0) {
+		if (thread_count <= 0)
+			thread_count = std::max(1u, std::thread::hardware_concurrency());
+
+		for (int t = 0; t < thread_count; t++)
+			workers.emplace_back([this, t]() { worker_loop(t); });
+	}
+
+	~render_pool() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		wake_workers.notify_all();
+
+		for (std::thread& worker : workers)
+			worker.join();
+	}
+
+	render_pool(const render_pool&) = delete;
+	render_pool& operator=(const render_pool&) = delete;
+
+	int size() const { return int(workers.size()); }
+
+	// Calls job(worker_index) once on every worker and blocks until all calls return.
+	void run(const std::function<void(int)>& job) {
+		std::unique_lock<std::mutex> lock(mutex);
+
+		current_job = &job;
+		remaining = int(workers.size());
+		generation++;
+		wake_workers.notify_all();
+
+		job_done.wait(lock, [this]() { return remaining == 0; });
+		current_job = nullptr;
+	}
+
+private:
+	// Pin each worker to one hardware thread. Without pinning the OS migrates workers
+	// between sockets mid-frame on multi-socket nodes, turning their first-touched
+	// (node-local) buffers into remote-memory traffic. One worker per hardware thread
+	// is the pool's sizing anyway, so pinning worker t to CPU t costs nothing on
+	// single-socket machines.
+	static void pin_to_cpu(int worker_index) {
+#ifdef _WIN32
+		SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << (worker_index % 64));
+#elif defined(__linux__)
+		cpu_set_t cpus;
+		CPU_ZERO(&cpus);
+		CPU_SET(worker_index % CPU_SETSIZE, &cpus);
+		pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+#endif
+	}
+
+	void worker_loop(int worker_index) {
+		pin_to_cpu(worker_index);
+
+		uint64_t seen_generation = 0;
+
+		while (true) {
+			const std::function<void(int)>* job;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				wake_workers.wait(lock, [&]() { return stopping || generation != seen_generation; });
+
+				if (stopping)
+					return;
+
+				seen_generation = generation;
+				job = current_job;
+			}
+
+			(*job)(worker_index);
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (--remaining == 0)
+					job_done.notify_one();
+			}
+		}
+	}
+
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable wake_workers; // Signaled when a job is posted (or the pool stops)
+	std::condition_variable job_done;     // Signaled by the last worker to finish a job
+
+	const std::function<void(int)>* current_job = nullptr;
+	uint64_t generation = 0; // Bumped per job so sleeping workers can tell old from new
+	int remaining = 0;
+	bool stopping = false;
+};
+
+// Process-wide pool sized to the hardware thread count, shared by every camera so
+// repeated render() calls reuse the same threads.
+inline render_pool& shared_render_pool() {
+	static render_pool pool;
+	return pool;
+}
+#endif
@@ -0,0 +1,122 @@
+#ifndef RENDER_STATS_H
+#define RENDER_STATS_H
+
+#include <cstdint>
+
+/*
+ * Render Statistics (compile-time gated)
+ * --------------------------------------
+ * Optional counters for the intersection and shading hot paths: rays traced, BVH node
+ * visits and leaf primitive tests, aabb slab tests, and scatter calls per material
+ * class. Off by default — every RT_STAT() expands to nothing and the layer costs
+ * literally zero. Define RT_STATS (project-wide preprocessor definition) to enable.
+ *
+ * Aggregation:
+ * ------------
+ * Counters accumulate into a plain thread_local struct (no atomics on the hot path)
+ * and are merged into a global total when each worker finishes its render job
+ * (render_stats_flush_thread, called by the camera's dispatch loop). The camera resets
+ * the global at frame start and logs the merged numbers after the frame.
+ *
+ * The camera can additionally record a per-pixel traversal-cost heatmap (see
+ * camera::heatmap_path) built from render_stats_traversal_count() deltas, which shows
+ * exactly which image regions burn the frame budget.
+ */
+
+#ifdef RT_STATS
+
+#include <iostream>
+#include <mutex>
+#include <string>
+
+struct render_stats {
+	uint64_t primary_rays = 0;
+	uint64_t secondary_rays = 0;
+	uint64_t bvh_node_visits = 0;
+	uint64_t bvh_leaf_tests = 0;   // Primitive hit() calls made from BVH leaves
+	uint64_t aabb_tests = 0;
+	uint64_t scatter_lambertian = 0;
+	uint64_t scatter_metal = 0;
+	uint64_t scatter_dielectric = 0;
+	uint64_t scatter_isotropic = 0;
+
+	void merge(const render_stats& other) {
+		primary_rays += other.primary_rays;
+		secondary_rays += other.secondary_rays;
+		bvh_node_visits += other.bvh_node_visits;
+		bvh_leaf_tests += other.bvh_leaf_tests;
+		aabb_tests += other.aabb_tests;
+		scatter_lambertian += other.scatter_lambertian;
+		scatter_metal += other.scatter_metal;
+		scatter_dielectric += other.scatter_dielectric;
+		scatter_isotropic += other.scatter_isotropic;
+	}
+};
+
+inline render_stats& local_render_stats() {
+	thread_local render_stats stats;
+	return stats;
+}
+
+inline std::mutex& render_stats_mutex() {
+	static std::mutex mutex;
+	return mutex;
+}
+
+inline render_stats& global_render_stats() {
+	static render_stats stats;
+	return stats;
+}
+
+#define RT_STAT(field) (local_render_stats().field++)
+#define RT_STAT_ADD(field, amount) (local_render_stats().field += (amount))
+
+inline void render_stats_begin_frame() {
+	std::lock_guard<std::mutex> lock(render_stats_mutex());
+	global_render_stats() = render_stats{};
+}
+
+// Merge this thread's counters into the global total and reset them. Called once per
+// worker when its render job ends — never on the per-ray path.
+inline void render_stats_flush_thread() {
+	std::lock_guard<std::mutex> lock(render_stats_mutex());
+	global_render_stats().merge(local_render_stats());
+	local_render_stats() = render_stats{};
+}
+
+// Running traversal cost of the current thread; per-pixel deltas feed the heatmap.
+inline uint64_t render_stats_traversal_count() {
+	const render_stats& stats = local_render_stats();
+	return stats.bvh_node_visits + stats.bvh_leaf_tests + stats.aabb_tests;
+}
+
+inline void render_stats_log(std::ostream& out) {
+	const render_stats& stats = global_render_stats();
+	uint64_t rays = stats.primary_rays + stats.secondary_rays;
+
+	out << "Render stats:\n"
+	    << "  rays traced       " << rays << " (" << stats.primary_rays << " primary, " << stats.secondary_rays << " secondary)\n"
+	    << "  bvh node visits   " << stats.bvh_node_visits << (rays ? " (" + std::to_string(stats.bvh_node_visits / rays) + "/ray)" : "") << "\n"
+	    << "  bvh leaf tests    " << stats.bvh_leaf_tests << "\n"
+	    << "  aabb slab tests   " << stats.aabb_tests << "\n"
+	    << "  scatters          " << stats.scatter_lambertian << " lambertian, " << stats.scatter_metal << " metal, "
+	    << stats.scatter_dielectric << " dielectric, " << stats.scatter_isotropic << " isotropic\n";
+}
+
+#else
+
+// Stats disabled: the macros vanish and the helpers compile to nothing, so call sites
+// need no #ifdef of their own.
+
+#define RT_STAT(field) ((void)0)
+#define RT_STAT_ADD(field, amount) ((void)0)
+
+inline void render_stats_begin_frame() {}
+inline void render_stats_flush_thread() {}
+inline uint64_t render_stats_traversal_count() { return 0; }
+
+template <class Stream>
+inline void render_stats_log(Stream&) {}
+
+#endif // RT_STATS
+#endif
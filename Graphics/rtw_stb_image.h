@@ -12,6 +12,11 @@
 
 #include <cstdlib>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 // Copied class from https://raytracing.github.io/books/RayTracingTheNextWeek.html#texturemapping/renderingtheimagetexture
 
@@ -19,7 +24,10 @@ class rtw_image {
 public:
     rtw_image() {}
 
-    rtw_image(const char* image_filename) {
+    // keep_float_data retains the linear float buffer after byte conversion. The
+    // renderer only samples the byte data (and the mips built from the floats), so the
+    // default drops it and roughly halves the memory held per decoded texture.
+    rtw_image(const char* image_filename, bool keep_float_data = false) : keep_float(keep_float_data) {
         // Loads image data from the specified file. If the RTW_IMAGES environment variable is
         // defined, looks only in that directory for the image file. If the image was not found,
         // searches for the specified image file first from the current directory, then in the
@@ -68,11 +76,18 @@ public:
 
         bytes_per_scanline = image_width * bytes_per_pixel;
         convert_to_bytes();
+        build_mip_pyramid();
+
+        if (!keep_float) {
+            STBI_FREE(fdata);
+            fdata = nullptr;
+        }
+
         return true;
     }
 
-    int width()  const { return (fdata == nullptr) ? 0 : image_width; }
-    int height() const { return (fdata == nullptr) ? 0 : image_height; }
+    int width()  const { return (bdata == nullptr) ? 0 : image_width; }
+    int height() const { return (bdata == nullptr) ? 0 : image_height; }
 
     const unsigned char* pixel_data(int x, int y) const {
         // Return the address of the three RGB bytes of the pixel at x,y. If there is no image
@@ -86,13 +101,45 @@ public:
         return bdata + y * bytes_per_scanline + x * bytes_per_pixel;
     }
 
+    // Mipmap pyramid: level 0 is the full image, each further level is a 2x2 box-filtered
+    // half-resolution copy, down to 1x1. Built once at load time from the float data so
+    // repeated downsampling never accumulates byte quantization error.
+
+    int mip_levels() const { return 1 + int(mips.size()); }
+
+    int mip_width(int level) const {
+        return (level <= 0) ? width() : mips[clamp(level, 1, mip_levels()) - 1].width;
+    }
+
+    int mip_height(int level) const {
+        return (level <= 0) ? height() : mips[clamp(level, 1, mip_levels()) - 1].height;
+    }
+
+    const unsigned char* mip_pixel_data(int level, int x, int y) const {
+        if (level <= 0 || mips.empty())
+            return pixel_data(x, y);
+
+        const mip_level& mip = mips[clamp(level, 1, mip_levels()) - 1];
+        x = clamp(x, 0, mip.width);
+        y = clamp(y, 0, mip.height);
+
+        return mip.data.data() + (y * mip.width + x) * bytes_per_pixel;
+    }
+
 private:
+    struct mip_level {
+        int width = 0, height = 0;
+        std::vector<unsigned char> data;
+    };
+
     const int      bytes_per_pixel = 3;
     float* fdata = nullptr;         // Linear floating point pixel data
     unsigned char* bdata = nullptr;         // Linear 8-bit pixel data
     int            image_width = 0;         // Loaded image width
     int            image_height = 0;        // Loaded image height
     int            bytes_per_scanline = 0;
+    bool           keep_float = false;      // Retain fdata after byte conversion
+    std::vector<mip_level> mips;            // Levels 1..n (level 0 lives in bdata)
 
     static int clamp(int x, int low, int high) {
         // Return the value clamped to the range [low, high).
@@ -124,8 +171,74 @@ private:
         for (auto i = 0; i < total_bytes; i++, fptr++, bptr++)
             *bptr = float_to_byte(*fptr);
     }
+
+    void build_mip_pyramid() {
+        mips.clear();
+
+        std::vector<float> source(fdata, fdata + size_t(image_width) * image_height * bytes_per_pixel);
+        int source_width = image_width;
+        int source_height = image_height;
+
+        while (source_width > 1 || source_height > 1) {
+            int mip_width = std::max(1, source_width / 2);
+            int mip_height = std::max(1, source_height / 2);
+
+            std::vector<float> filtered(size_t(mip_width) * mip_height * bytes_per_pixel);
+
+            for (int y = 0; y < mip_height; y++) {
+                // Clamp the second sample on odd-sized (or already size 1) source axes
+                int y0 = std::min(2 * y, source_height - 1);
+                int y1 = std::min(2 * y + 1, source_height - 1);
+
+                for (int x = 0; x < mip_width; x++) {
+                    int x0 = std::min(2 * x, source_width - 1);
+                    int x1 = std::min(2 * x + 1, source_width - 1);
+
+                    for (int c = 0; c < bytes_per_pixel; c++) {
+                        filtered[(size_t(y) * mip_width + x) * bytes_per_pixel + c] = 0.25f * (
+                            source[(size_t(y0) * source_width + x0) * bytes_per_pixel + c] +
+                            source[(size_t(y0) * source_width + x1) * bytes_per_pixel + c] +
+                            source[(size_t(y1) * source_width + x0) * bytes_per_pixel + c] +
+                            source[(size_t(y1) * source_width + x1) * bytes_per_pixel + c]);
+                    }
+                }
+            }
+
+            mip_level level;
+            level.width = mip_width;
+            level.height = mip_height;
+            level.data.resize(filtered.size());
+            for (size_t i = 0; i < filtered.size(); i++)
+                level.data[i] = float_to_byte(filtered[i]);
+            mips.push_back(std::move(level));
+
+            source = std::move(filtered);
+            source_width = mip_width;
+            source_height = mip_height;
+        }
+    }
 };
 
+// Process-wide image cache keyed by the filename passed in. Scene descriptions
+// reference the same texture file from many materials, and decoding a multi-megabyte
+// JPEG once per reference dominated scene startup; with the cache every path is decoded
+// exactly once and the instances share one immutable rtw_image. Thread-safe, so scenes
+// may be built from worker threads.
+inline std::shared_ptr<const rtw_image> load_image_cached(const std::string& filename) {
+    static std::mutex cache_mutex;
+    static std::unordered_map<std::string, std::shared_ptr<const rtw_image>> cache;
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+
+    auto cached = cache.find(filename);
+    if (cached != cache.end())
+        return cached->second;
+
+    auto image = std::make_shared<const rtw_image>(filename.c_str());
+    cache[filename] = image;
+    return image;
+}
+
 // Restore MSVC compiler warnings
 #ifdef _MSC_VER
 #pragma warning (pop)
@@ -0,0 +1,100 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include "hittable_list.h"
+#include "quad.h"
+
+#include <deque>
+#include <typeindex>
+#include <unordered_map>
+
+/*
+ * Scene (arena-backed object storage)
+ * -----------------------------------
+ * Owns every primitive, material, and texture of a scene in contiguous typed arenas
+ * instead of one individual heap allocation (plus shared_ptr control block) per object.
+ *
+ * Why:
+ * ----
+ * final_scene creates ~1400 separately allocated objects through make_shared, so the
+ * intersection hot path walks pointers scattered across the heap. Allocating each type
+ * into its own deque keeps objects of one kind packed in large blocks (deque blocks
+ * never move, so addresses stay stable), which makes scene construction cheaper and
+ * keeps intersection data cache-resident.
+ *
+ * Usage:
+ * ------
+ * scene sc;
+ * auto white = sc.make<lambertian>(color(.73, .73, .73));
+ * sc.add(sc.make<sphere>(point3(0, 0, 0), 10, white));
+ * cam.render(sc.world);
+ *
+ * The shared_ptr handed back by make() is non-owning (no-op deleter), so it plugs into
+ * the existing hittable_list / material interfaces unchanged; the scene must simply
+ * outlive the render, which every scene function already guarantees.
+ */
+
+class scene {
+public:
+	hittable_list world;
+
+	// Allocate an object inside the scene-owned arena for its type and hand back a
+	// non-owning shared_ptr compatible with the existing interfaces.
+	template <class T, class... Args>
+	shared_ptr<T> make(Args&&... args) {
+		std::deque<T>& storage = arena_for<T>();
+		storage.emplace_back(std::forward<Args>(args)...);
+		return shared_ptr<T>(&storage.back(), [](T*) {});
+	}
+
+	void add(shared_ptr<hittable> hittable_object) {
+		world.add(hittable_object);
+	}
+
+private:
+	struct arena_base {
+		virtual ~arena_base() = default;
+	};
+
+	template <class T>
+	struct typed_arena : arena_base {
+		std::deque<T> storage;
+	};
+
+	std::unordered_map<std::type_index, shared_ptr<arena_base>> arenas;
+
+	template <class T>
+	std::deque<T>& arena_for() {
+		std::type_index key(typeid(T));
+
+		auto found = arenas.find(key);
+		if (found == arenas.end())
+			found = arenas.emplace(key, make_shared<typed_arena<T>>()).first;
+
+		return static_cast<typed_arena<T>*>(found->second.get())->storage;
+	}
+};
+
+inline shared_ptr<hittable_list> box(const point3& a, const point3& b, shared_ptr<material> mat, scene& owner)
+{
+	// Arena-backed variant of box() from quad.h: the six quads and their list live in
+	// the scene's typed storage instead of six separate heap allocations.
+	auto sides = owner.make<hittable_list>();
+
+	auto min = point3(std::fmin(a.x(), b.x()), std::fmin(a.y(), b.y()), std::fmin(a.z(), b.z()));
+	auto max = point3(std::fmax(a.x(), b.x()), std::fmax(a.y(), b.y()), std::fmax(a.z(), b.z()));
+
+	auto dx = vec3(max.x() - min.x(), 0, 0);
+	auto dy = vec3(0, max.y() - min.y(), 0);
+	auto dz = vec3(0, 0, max.z() - min.z());
+
+	sides->add(owner.make<quad>(point3(min.x(), min.y(), max.z()), dx, dy, mat)); // front
+	sides->add(owner.make<quad>(point3(max.x(), min.y(), max.z()), -dz, dy, mat)); // right
+	sides->add(owner.make<quad>(point3(max.x(), min.y(), min.z()), -dx, dy, mat)); // back
+	sides->add(owner.make<quad>(point3(min.x(), min.y(), min.z()), dz, dy, mat)); // left
+	sides->add(owner.make<quad>(point3(min.x(), max.y(), max.z()), dx, -dz, mat)); // top
+	sides->add(owner.make<quad>(point3(min.x(), min.y(), min.z()), dx, dz, mat)); // bottom
+
+	return sides;
+}
+#endif
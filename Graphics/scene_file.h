@@ -0,0 +1,705 @@
+#ifndef SCENE_FILE_H
+#define SCENE_FILE_H
+
+#include "bvh.h"
+#include "camera.h"
+#include "constant_medium.h"
+#include "scene.h"
+#include "sphere.h"
+#include "sphere_batch.h"
+#include "transform.h"
+
+#include <cstdio>
+#include <cstring>
+#include <set>
+#include <unordered_map>
+
+/*
+ * Binary Scene File ("RTSC")
+ * --------------------------
+ * Compact on-disk form of a hittable_list plus camera parameters, so a scene built
+ * once (final_scene alone derives 400 boxes and 1000 spheres from random_double())
+ * can be reloaded per run or per frame without recompiling or re-deriving anything.
+ *
+ * Layout (little-endian, fixed-size POD records, written in one pass):
+ *   file_header | camera_record | string table | texture records | material records
+ *   | object record stream
+ *
+ * Textures and materials are deduplicated by pointer and referenced by index, so the
+ * 1000 spheres of final_scene that share one lambertian serialize it once. The object
+ * stream is a prefix encoding: a list record is followed by its children, a wrapper
+ * record (translate, rotate_y, constant_medium) by its single child. BVH nodes are
+ * not stored structurally — their primitives are flattened into a list flagged for
+ * rebuild, and the loader reconstructs a bvh_flat over them (the build is cheap next
+ * to a render, and it keeps the format independent of the in-memory node layout).
+ *
+ * The loader reads the whole file with a single bulk read, then walks the records and
+ * batch-constructs every object into the caller's scene arena, so loaded scenes get
+ * the same contiguous storage as ones built in code.
+ *
+ * scene_file covers the object, material, and texture types the scene functions use
+ * (sphere, quad, lists, transforms, constant_medium; lambertian, metal, dielectric,
+ * diffuse_light, isotropic; solid, checker, noise, image textures). save() returns
+ * false on anything it does not recognize rather than writing a partial file.
+ */
+
+class scene_file {
+public:
+	// Writes world + camera to path. Returns false (with a clog message) on I/O
+	// failure or an unsupported object/material/texture type.
+	static bool save(const std::string& path, const hittable_list& world, const camera& cam) {
+		writer w;
+		if (cam.lights) {
+			if (const hittable_list* list = dynamic_cast<const hittable_list*>(cam.lights.get())) {
+				for (const shared_ptr<hittable>& light : list->hittables)
+					w.lights.insert(light.get());
+			}
+			else {
+				w.lights.insert(cam.lights.get());
+			}
+		}
+
+		// Root record: the world list itself.
+		object_record root = {};
+		root.kind = object_kind::list;
+		root.child_count = uint32_t(world.hittables.size());
+		w.objects.push_back(root);
+		for (const shared_ptr<hittable>& object : world.hittables)
+			if (!w.write_object(object.get()))
+				return false;
+
+		file_header header = {};
+		std::memcpy(header.magic, "RTSC", 4);
+		header.version = 1;
+		header.texture_count = uint32_t(w.textures.size());
+		header.material_count = uint32_t(w.materials.size());
+		header.object_count = uint32_t(w.objects.size());
+		header.string_bytes = uint32_t(w.strings.size());
+
+		camera_record cam_record = pack_camera(cam);
+
+		std::FILE* out = std::fopen(path.c_str(), "wb");
+		if (!out) {
+			std::clog << "scene_file: cannot open '" << path << "' for writing\n";
+			return false;
+		}
+
+		bool ok = std::fwrite(&header, sizeof(header), 1, out) == 1
+		       && std::fwrite(&cam_record, sizeof(cam_record), 1, out) == 1
+		       && write_all(out, w.strings.data(), w.strings.size())
+		       && write_all(out, w.textures.data(), w.textures.size() * sizeof(texture_record))
+		       && write_all(out, w.materials.data(), w.materials.size() * sizeof(material_record))
+		       && write_all(out, w.objects.data(), w.objects.size() * sizeof(object_record));
+		std::fclose(out);
+
+		if (!ok)
+			std::clog << "scene_file: short write to '" << path << "'\n";
+		return ok;
+	}
+
+	// Reads path into world/cam, constructing every object inside arena. Returns false
+	// (with a clog message) if the file is missing, truncated, or not an RTSC file.
+	static bool load(const std::string& path, scene& arena, hittable_list& world, camera& cam) {
+		std::vector<unsigned char> data;
+		if (!read_whole_file(path, data))
+			return false;
+
+		reader r = { data.data(), data.size(), 0 };
+
+		file_header header;
+		if (!r.read(&header, sizeof(header)) || std::memcmp(header.magic, "RTSC", 4) != 0 || header.version != 1) {
+			std::clog << "scene_file: '" << path << "' is not a version-1 RTSC scene\n";
+			return false;
+		}
+
+		camera_record cam_record;
+		if (!r.read(&cam_record, sizeof(cam_record)))
+			return bad_file(path);
+		unpack_camera(cam_record, cam);
+
+		if (r.cursor + header.string_bytes > r.size)
+			return bad_file(path);
+		const char* strings = reinterpret_cast<const char*>(r.data + r.cursor);
+		r.cursor += header.string_bytes;
+
+		loader l;
+		l.arena = &arena;
+
+		// Texture records only ever reference earlier textures (checker children are
+		// written first), so one forward pass resolves everything.
+		for (uint32_t i = 0; i < header.texture_count; i++) {
+			texture_record record;
+			if (!r.read(&record, sizeof(record)))
+				return bad_file(path);
+			shared_ptr<texture> tex = l.make_texture(record, strings, header.string_bytes);
+			if (!tex)
+				return bad_file(path);
+			l.textures.push_back(tex);
+		}
+
+		for (uint32_t i = 0; i < header.material_count; i++) {
+			material_record record;
+			if (!r.read(&record, sizeof(record)))
+				return bad_file(path);
+			shared_ptr<material> mat = l.make_material(record);
+			if (!mat)
+				return bad_file(path);
+			l.materials.push_back(mat);
+		}
+
+		if (r.cursor + header.object_count * sizeof(object_record) > r.size)
+			return bad_file(path);
+		l.records = reinterpret_cast<const object_record*>(r.data + r.cursor);
+		l.record_count = header.object_count;
+		l.next_record = 0;
+
+		// The root record is the world list: load its children straight into world.
+		object_record root;
+		if (!l.next(root) || root.kind != object_kind::list)
+			return bad_file(path);
+		for (uint32_t i = 0; i < root.child_count; i++) {
+			shared_ptr<hittable> object = l.load_object();
+			if (!object)
+				return bad_file(path);
+			world.add(object);
+		}
+
+		if (!l.loaded_lights.empty()) {
+			auto lights = arena.make<hittable_list>();
+			for (const shared_ptr<hittable>& light : l.loaded_lights)
+				lights->add(light);
+			cam.lights = lights;
+		}
+
+		return true;
+	}
+
+private:
+	struct object_kind {
+		enum : uint8_t { sphere_static, sphere_moving, quad_prim, list, translated, rotated_y, medium, batch, instanced };
+	};
+	struct material_kind {
+		enum : uint8_t { lambertian_mat, metal_mat, dielectric_mat, diffuse_light_mat, isotropic_mat };
+	};
+	struct texture_kind {
+		enum : uint8_t { solid, checker, noise, image };
+	};
+	struct object_flag {
+		enum : uint8_t { light = 1, rebuild_bvh = 2 };
+	};
+
+	struct file_header {
+		char     magic[4];
+		uint32_t version;
+		uint32_t texture_count;
+		uint32_t material_count;
+		uint32_t object_count;
+		uint32_t string_bytes;
+	};
+
+	struct camera_record {
+		double   aspect_ratio;
+		int32_t  image_width;
+		int32_t  samples_per_pixel;
+		uint16_t max_depth;
+		uint16_t rr_min_bounces;
+		uint8_t  pad[4];
+		double   background[3];
+		double   vfov;
+		double   lookfrom[3];
+		double   lookat[3];
+		double   vup[3];
+		double   defocus_angle;
+		double   focus_dist;
+	};
+
+	struct texture_record {
+		uint8_t  kind;
+		uint8_t  pad[3];
+		uint32_t name_offset;  // image: offset of a NUL-terminated path in the string table
+		uint32_t even, odd;    // checker: indices of earlier texture records
+		double   scale;        // checker tile scale or noise frequency
+		double   rgb[3];       // solid color
+	};
+
+	struct material_record {
+		uint8_t  kind;
+		uint8_t  pad[3];
+		uint32_t texture;      // lambertian / diffuse_light / isotropic
+		double   rgb[3];       // metal albedo
+		double   scalar;       // metal fuzz or dielectric refraction index
+	};
+
+	struct object_record {
+		uint8_t  kind;
+		uint8_t  flags;
+		uint8_t  pad[2];
+		uint32_t material;     // spheres/quads: material index; medium: phase texture index
+		uint32_t child_count;  // lists only
+		double   v[12];        // geometry: centers+radius, Q/u/v, offset, angle, density, affine rows
+	};
+
+	// ---- serialization ----
+
+	struct writer {
+		std::vector<texture_record> textures;
+		std::vector<material_record> materials;
+		std::vector<object_record> objects;
+		std::vector<char> strings;
+		std::unordered_map<const texture*, uint32_t> texture_index;
+		std::unordered_map<const material*, uint32_t> material_index;
+		std::set<const hittable*> lights;
+
+		uint32_t add_string(const std::string& text) {
+			uint32_t offset = uint32_t(strings.size());
+			strings.insert(strings.end(), text.begin(), text.end());
+			strings.push_back('\0');
+			return offset;
+		}
+
+		// Returns the record index for tex, serializing it (and, for checkers, its
+		// children first) on first sight. ~0u marks an unsupported texture type.
+		uint32_t register_texture(const texture* tex) {
+			auto found = texture_index.find(tex);
+			if (found != texture_index.end())
+				return found->second;
+
+			texture_record record = {};
+			if (const solid_color* s = dynamic_cast<const solid_color*>(tex)) {
+				record.kind = texture_kind::solid;
+				store3(record.rgb, s->albedo);
+			}
+			else if (const checker_texture* c = dynamic_cast<const checker_texture*>(tex)) {
+				record.kind = texture_kind::checker;
+				record.scale = 1.0 / c->inv_scale;
+				record.even = register_texture(c->even.get());
+				record.odd = register_texture(c->odd.get());
+				if (record.even == ~0u || record.odd == ~0u)
+					return ~0u;
+			}
+			else if (const noise_texture* n = dynamic_cast<const noise_texture*>(tex)) {
+				record.kind = texture_kind::noise;
+				record.scale = n->scale;
+			}
+			else if (const image_texture* img = dynamic_cast<const image_texture*>(tex)) {
+				record.kind = texture_kind::image;
+				record.name_offset = add_string(img->filename);
+			}
+			else {
+				std::clog << "scene_file: unsupported texture type\n";
+				return ~0u;
+			}
+
+			uint32_t index = uint32_t(textures.size());
+			textures.push_back(record);
+			texture_index.emplace(tex, index);
+			return index;
+		}
+
+		uint32_t register_material(const material* mat) {
+			auto found = material_index.find(mat);
+			if (found != material_index.end())
+				return found->second;
+
+			material_record record = {};
+			uint32_t tex = 0;
+			if (const lambertian* l = dynamic_cast<const lambertian*>(mat)) {
+				record.kind = material_kind::lambertian_mat;
+				tex = register_texture(l->tex.get());
+			}
+			else if (const metal* m = dynamic_cast<const metal*>(mat)) {
+				record.kind = material_kind::metal_mat;
+				store3(record.rgb, m->albedo);
+				record.scalar = m->fuzz;
+			}
+			else if (const dielectric* d = dynamic_cast<const dielectric*>(mat)) {
+				record.kind = material_kind::dielectric_mat;
+				record.scalar = d->refraction_index;
+			}
+			else if (const diffuse_light* dl = dynamic_cast<const diffuse_light*>(mat)) {
+				record.kind = material_kind::diffuse_light_mat;
+				tex = register_texture(dl->tex.get());
+			}
+			else if (const isotropic* iso = dynamic_cast<const isotropic*>(mat)) {
+				record.kind = material_kind::isotropic_mat;
+				tex = register_texture(iso->tex.get());
+			}
+			else {
+				std::clog << "scene_file: unsupported material type\n";
+				return ~0u;
+			}
+
+			if (tex == ~0u)
+				return ~0u;
+			record.texture = tex;
+
+			uint32_t index = uint32_t(materials.size());
+			materials.push_back(record);
+			material_index.emplace(mat, index);
+			return index;
+		}
+
+		bool write_object(const hittable* object) {
+			object_record record = {};
+			if (lights.count(object))
+				record.flags |= object_flag::light;
+
+			if (const sphere* s = dynamic_cast<const sphere*>(object)) {
+				bool moving = s->center.direction().length_squared() > 0;
+				record.kind = moving ? object_kind::sphere_moving : object_kind::sphere_static;
+				store3(record.v + 0, s->center.at(0));
+				store3(record.v + 3, s->center.at(1));
+				record.v[6] = s->radius;
+				record.material = register_material(s->mat.get());
+			}
+			else if (const quad* q = dynamic_cast<const quad*>(object)) {
+				record.kind = object_kind::quad_prim;
+				store3(record.v + 0, q->Q);
+				store3(record.v + 3, q->u);
+				store3(record.v + 6, q->v);
+				record.material = register_material(q->mat.get());
+			}
+			else if (const hittable_list* list = dynamic_cast<const hittable_list*>(object)) {
+				record.kind = object_kind::list;
+				record.child_count = uint32_t(list->hittables.size());
+				objects.push_back(record);
+				for (const shared_ptr<hittable>& child : list->hittables)
+					if (!write_object(child.get()))
+						return false;
+				return true;
+			}
+			else if (const translate* t = dynamic_cast<const translate*>(object)) {
+				record.kind = object_kind::translated;
+				store3(record.v, t->offset);
+				objects.push_back(record);
+				return write_object(t->hittable_object.get());
+			}
+			else if (const rotate_y* rot = dynamic_cast<const rotate_y*>(object)) {
+				record.kind = object_kind::rotated_y;
+				record.v[0] = std::atan2(rot->sin_theta, rot->cos_theta) * 180.0 / pi;
+				objects.push_back(record);
+				return write_object(rot->hittable_object.get());
+			}
+			else if (const constant_medium* cm = dynamic_cast<const constant_medium*>(object)) {
+				const isotropic* phase = dynamic_cast<const isotropic*>(cm->phase_function.get());
+				if (!phase) {
+					std::clog << "scene_file: constant_medium with non-isotropic phase function\n";
+					return false;
+				}
+				record.kind = object_kind::medium;
+				record.v[0] = -1.0 / cm->neg_inv_density;
+				record.material = register_texture(phase->tex.get());
+				if (record.material == ~0u)
+					return false;
+				objects.push_back(record);
+				return write_object(cm->boundary.get());
+			}
+			else if (const sphere_batch* batch = dynamic_cast<const sphere_batch*>(object)) {
+				// Stored as a run of static sphere records; the loader refills the SoA arrays.
+				record.kind = object_kind::batch;
+				record.child_count = uint32_t(batch->radii.size());
+				objects.push_back(record);
+				for (size_t i = 0; i < batch->radii.size(); i++) {
+					object_record member = {};
+					member.kind = object_kind::sphere_static;
+					member.v[0] = batch->cx[i];
+					member.v[1] = batch->cy[i];
+					member.v[2] = batch->cz[i];
+					member.v[6] = batch->radii[i];
+					member.material = register_material(batch->materials[i].get());
+					if (member.material == ~0u)
+						return false;
+					objects.push_back(member);
+				}
+				return true;
+			}
+			else if (const bvh_flat* flat = dynamic_cast<const bvh_flat*>(object)) {
+				// Store the primitives, not the tree: the loader rebuilds a bvh_flat.
+				record.kind = object_kind::list;
+				record.flags |= object_flag::rebuild_bvh;
+				record.child_count = uint32_t(flat->primitives.size());
+				objects.push_back(record);
+				for (const shared_ptr<hittable>& child : flat->primitives)
+					if (!write_object(child.get()))
+						return false;
+				return true;
+			}
+			else if (dynamic_cast<const bvh_node*>(object)) {
+				std::vector<const hittable*> leaves;
+				collect_bvh_leaves(static_cast<const bvh_node*>(object), leaves);
+				record.kind = object_kind::list;
+				record.flags |= object_flag::rebuild_bvh;
+				record.child_count = uint32_t(leaves.size());
+				objects.push_back(record);
+				for (const hittable* child : leaves)
+					if (!write_object(child))
+						return false;
+				return true;
+			}
+			else if (const instance* inst = dynamic_cast<const instance*>(object)) {
+				record.kind = object_kind::instanced;
+				for (int row = 0; row < 3; row++)
+					for (int column = 0; column < 4; column++)
+						record.v[row * 4 + column] = inst->forward.m[row][column];
+				objects.push_back(record);
+				return write_object(inst->hittable_object.get());
+			}
+			else {
+				std::clog << "scene_file: unsupported hittable type\n";
+				return false;
+			}
+
+			if (record.material == ~0u)
+				return false;
+			objects.push_back(record);
+			return true;
+		}
+
+		void collect_bvh_leaves(const bvh_node* node, std::vector<const hittable*>& leaves) {
+			const hittable* children[2] = { node->left.get(), node->right.get() };
+			int count = (children[0] == children[1]) ? 1 : 2; // Single-leaf nodes alias left == right
+			for (int i = 0; i < count; i++) {
+				if (const bvh_node* inner = dynamic_cast<const bvh_node*>(children[i]))
+					collect_bvh_leaves(inner, leaves);
+				else
+					leaves.push_back(children[i]);
+			}
+		}
+	};
+
+	// ---- loading ----
+
+	struct reader {
+		const unsigned char* data;
+		size_t size;
+		size_t cursor;
+
+		bool read(void* dst, size_t bytes) {
+			if (cursor + bytes > size)
+				return false;
+			std::memcpy(dst, data + cursor, bytes);
+			cursor += bytes;
+			return true;
+		}
+	};
+
+	struct loader {
+		scene* arena;
+		std::vector<shared_ptr<texture>> textures;
+		std::vector<shared_ptr<material>> materials;
+		const object_record* records = nullptr;
+		uint32_t record_count = 0;
+		uint32_t next_record = 0;
+		std::vector<shared_ptr<hittable>> loaded_lights;
+
+		bool next(object_record& record) {
+			if (next_record >= record_count)
+				return false;
+			record = records[next_record++];
+			return true;
+		}
+
+		shared_ptr<texture> make_texture(const texture_record& record, const char* strings, uint32_t string_bytes) {
+			switch (record.kind) {
+			case texture_kind::solid:
+				return arena->make<solid_color>(load3(record.rgb));
+			case texture_kind::checker:
+				if (record.even >= textures.size() || record.odd >= textures.size())
+					return nullptr;
+				return arena->make<checker_texture>(record.scale, textures[record.even], textures[record.odd]);
+			case texture_kind::noise:
+				return arena->make<noise_texture>(record.scale);
+			case texture_kind::image:
+				if (record.name_offset >= string_bytes)
+					return nullptr;
+				return arena->make<image_texture>(strings + record.name_offset);
+			}
+			return nullptr;
+		}
+
+		shared_ptr<material> make_material(const material_record& record) {
+			bool needs_texture = record.kind == material_kind::lambertian_mat
+			                  || record.kind == material_kind::diffuse_light_mat
+			                  || record.kind == material_kind::isotropic_mat;
+			if (needs_texture && record.texture >= textures.size())
+				return nullptr;
+
+			switch (record.kind) {
+			case material_kind::lambertian_mat:
+				return arena->make<lambertian>(textures[record.texture]);
+			case material_kind::metal_mat:
+				return arena->make<metal>(load3(record.rgb), record.scalar);
+			case material_kind::dielectric_mat:
+				return arena->make<dielectric>(record.scalar);
+			case material_kind::diffuse_light_mat:
+				return arena->make<diffuse_light>(textures[record.texture]);
+			case material_kind::isotropic_mat:
+				return arena->make<isotropic>(textures[record.texture]);
+			}
+			return nullptr;
+		}
+
+		shared_ptr<hittable> load_object() {
+			object_record record;
+			if (!next(record))
+				return nullptr;
+
+			shared_ptr<hittable> object;
+			switch (record.kind) {
+			case object_kind::sphere_static:
+			case object_kind::sphere_moving: {
+				if (record.material >= materials.size())
+					return nullptr;
+				point3 center1 = load3(record.v + 0);
+				if (record.kind == object_kind::sphere_moving)
+					object = arena->make<sphere>(center1, point3(load3(record.v + 3)), record.v[6], materials[record.material]);
+				else
+					object = arena->make<sphere>(center1, record.v[6], materials[record.material]);
+				break;
+			}
+			case object_kind::quad_prim:
+				if (record.material >= materials.size())
+					return nullptr;
+				object = arena->make<quad>(load3(record.v + 0), load3(record.v + 3), load3(record.v + 6), materials[record.material]);
+				break;
+			case object_kind::list: {
+				hittable_list children;
+				for (uint32_t i = 0; i < record.child_count; i++) {
+					shared_ptr<hittable> child = load_object();
+					if (!child)
+						return nullptr;
+					children.add(child);
+				}
+				if (record.flags & object_flag::rebuild_bvh)
+					object = arena->make<bvh_flat>(children, sah_binned);
+				else
+					object = arena->make<hittable_list>(std::move(children));
+				break;
+			}
+			case object_kind::translated: {
+				shared_ptr<hittable> child = load_object();
+				if (!child)
+					return nullptr;
+				object = arena->make<translate>(child, load3(record.v));
+				break;
+			}
+			case object_kind::rotated_y: {
+				shared_ptr<hittable> child = load_object();
+				if (!child)
+					return nullptr;
+				object = arena->make<rotate_y>(child, record.v[0]);
+				break;
+			}
+			case object_kind::batch: {
+				auto loaded = arena->make<sphere_batch>();
+				for (uint32_t i = 0; i < record.child_count; i++) {
+					object_record member;
+					if (!next(member) || member.kind != object_kind::sphere_static || member.material >= materials.size())
+						return nullptr;
+					loaded->add(point3(load3(member.v)), member.v[6], materials[member.material]);
+				}
+				object = loaded;
+				break;
+			}
+			case object_kind::instanced: {
+				shared_ptr<hittable> child = load_object();
+				if (!child)
+					return nullptr;
+				affine transform;
+				for (int row = 0; row < 3; row++)
+					for (int column = 0; column < 4; column++)
+						transform.m[row][column] = record.v[row * 4 + column];
+				object = arena->make<instance>(child, transform);
+				break;
+			}
+			case object_kind::medium: {
+				if (record.material >= textures.size())
+					return nullptr;
+				shared_ptr<hittable> boundary = load_object();
+				if (!boundary)
+					return nullptr;
+				object = arena->make<constant_medium>(boundary, record.v[0], textures[record.material]);
+				break;
+			}
+			default:
+				return nullptr;
+			}
+
+			if (object && (record.flags & object_flag::light))
+				loaded_lights.push_back(object);
+			return object;
+		}
+	};
+
+	// ---- helpers ----
+
+	static camera_record pack_camera(const camera& cam) {
+		camera_record record = {};
+		record.aspect_ratio = cam.aspect_ratio;
+		record.image_width = cam.image_width;
+		record.samples_per_pixel = cam.samples_per_pixel;
+		record.max_depth = cam.max_depth;
+		record.rr_min_bounces = cam.rr_min_bounces;
+		store3(record.background, cam.background);
+		record.vfov = cam.vfov;
+		store3(record.lookfrom, cam.lookfrom);
+		store3(record.lookat, cam.lookat);
+		store3(record.vup, cam.vup);
+		record.defocus_angle = cam.defocus_angle;
+		record.focus_dist = cam.focus_dist;
+		return record;
+	}
+
+	static void unpack_camera(const camera_record& record, camera& cam) {
+		cam.aspect_ratio = record.aspect_ratio;
+		cam.image_width = record.image_width;
+		cam.samples_per_pixel = record.samples_per_pixel;
+		cam.max_depth = record.max_depth;
+		cam.rr_min_bounces = record.rr_min_bounces;
+		cam.background = load3(record.background);
+		cam.vfov = record.vfov;
+		cam.lookfrom = load3(record.lookfrom);
+		cam.lookat = load3(record.lookat);
+		cam.vup = load3(record.vup);
+		cam.defocus_angle = record.defocus_angle;
+		cam.focus_dist = record.focus_dist;
+	}
+
+	static void store3(double* dst, const vec3& v) {
+		dst[0] = v.x(); dst[1] = v.y(); dst[2] = v.z();
+	}
+
+	static vec3 load3(const double* src) {
+		return vec3(src[0], src[1], src[2]);
+	}
+
+	static bool write_all(std::FILE* out, const void* data, size_t bytes) {
+		return bytes == 0 || std::fwrite(data, 1, bytes, out) == bytes;
+	}
+
+	static bool read_whole_file(const std::string& path, std::vector<unsigned char>& data) {
+		std::FILE* in = std::fopen(path.c_str(), "rb");
+		if (!in) {
+			std::clog << "scene_file: cannot open '" << path << "'\n";
+			return false;
+		}
+
+		std::fseek(in, 0, SEEK_END);
+		long size = std::ftell(in);
+		std::fseek(in, 0, SEEK_SET);
+
+		data.resize(size > 0 ? size_t(size) : 0);
+		bool ok = data.empty() || std::fread(data.data(), 1, data.size(), in) == data.size();
+		std::fclose(in);
+
+		if (!ok)
+			std::clog << "scene_file: failed to read '" << path << "'\n";
+		return ok;
+	}
+
+	static bool bad_file(const std::string& path) {
+		std::clog << "scene_file: '" << path << "' is truncated or malformed\n";
+		return false;
+	}
+};
+#endif
@@ -0,0 +1,434 @@
+#ifndef SCENES_H
+#define SCENES_H
+
+#include "helper.h"
+
+#include "bvh.h"
+#include "camera.h"
+#include "hittable.h"
+#include "hittable_list.h"
+#include "quad.h"
+#include "constant_medium.h"
+#include "sphere.h"
+#include "sphere_batch.h"
+#include "texture.h"
+#include "rtw_stb_image.h"
+#include "scene.h"
+#include "transform.h"
+
+#include <vector>
+
+/*
+ * Scene Builders
+ * --------------
+ * Each build_* function constructs one of the showcase scenes (world plus configured
+ * camera) without rendering it, so the same definitions serve both main() and the
+ * benchmark harness. The returned scene_setup owns everything the world references:
+ * the arena (for arena-allocated scenes) travels with it, so the setup can be moved
+ * around but the world must not outlive it.
+ */
+
+struct scene_setup {
+	scene arena;          // Backs arena-allocated objects; empty for shared_ptr scenes
+	hittable_list world;
+	camera cam;
+};
+
+inline scene_setup build_final_scene(int image_width, int samples_per_pixel, int max_depth) {
+	scene_setup setup;
+	scene& sc = setup.arena; // Arena ownership for every primitive/material below
+
+	hittable_list boxes1;
+	auto ground = sc.make<lambertian>(color(0.48, 0.83, 0.53));
+
+	int boxes_per_side = 20;
+	for (int i = 0; i < boxes_per_side; i++) {
+		for (int j = 0; j < boxes_per_side; j++) {
+			auto w = 100.0;
+			auto x0 = -1000.0 + i * w;
+			auto z0 = -1000.0 + j * w;
+			auto y0 = 0.0;
+			auto x1 = x0 + w;
+			auto y1 = random_double(1, 101);
+			auto z1 = z0 + w;
+
+			boxes1.add(box(point3(x0, y0, z0), point3(x1, y1, z1), ground, sc));
+		}
+	}
+
+	hittable_list& world = setup.world;
+
+	world.add(make_shared<bvh_flat>(boxes1, sah_binned));
+
+	auto light = sc.make<diffuse_light>(color(7, 7, 7));
+	auto light_quad = sc.make<quad>(point3(123, 554, 147), vec3(300, 0, 0), vec3(0, 0, 265), light);
+	world.add(light_quad);
+
+	auto center1 = point3(400, 400, 200);
+	auto center2 = center1 + vec3(30, 0, 0);
+	auto sphere_material = sc.make<lambertian>(color(0.7, 0.3, 0.1));
+	world.add(sc.make<sphere>(center1, center2, 50, sphere_material));
+
+	world.add(sc.make<sphere>(point3(260, 150, 45), 50, sc.make<dielectric>(1.5)));
+	world.add(sc.make<sphere>(point3(0, 150, 145), 50, sc.make<metal>(color(0.8, 0.8, 0.9), 1.0)));
+
+	auto boundary = sc.make<sphere>(point3(360, 150, 145), 70, sc.make<dielectric>(1.5));
+	world.add(boundary);
+	world.add(sc.make<constant_medium>(boundary, 0.2, color(0.2, 0.4, 0.9)));
+	boundary = sc.make<sphere>(point3(0, 0, 0), 5000, sc.make<dielectric>(1.5));
+	world.add(sc.make<constant_medium>(boundary, .0001, color(1, 1, 1)));
+
+	auto emat = sc.make<lambertian>(sc.make<image_texture>("earthmap.jpg"));
+	world.add(sc.make<sphere>(point3(400, 200, 400), 100, emat));
+	auto pertext = sc.make<noise_texture>(0.2);
+	world.add(sc.make<sphere>(point3(220, 280, 300), 80, sc.make<lambertian>(pertext)));
+
+	auto white = sc.make<lambertian>(color(.73, .73, .73));
+	int ns = 1000;
+	std::vector<sphere_desc> cluster;
+	for (int j = 0; j < ns; j++) {
+		cluster.push_back({ point3::random(interval(0, 165)), 10, white });
+	}
+	hittable_list boxes2 = make_sphere_batches(std::move(cluster), 64);
+
+	// Bake the placement into the sphere centers so rays pay no per-hit transform.
+	affine cluster_placement = affine::translation(vec3(-100, 270, 395)) * affine::rotation_y(15);
+	world.add(instance::apply(sc.make<bvh_flat>(boxes2, sah_binned), cluster_placement, sc));
+
+	camera& cam = setup.cam;
+
+	cam.aspect_ratio = 1.0;
+	cam.image_width = image_width;
+	cam.samples_per_pixel = samples_per_pixel;
+	cam.max_depth = max_depth;
+	cam.background = color(0, 0, 0);
+
+	cam.vfov = 40;
+	cam.lookfrom = point3(478, 278, -600);
+	cam.lookat = point3(278, 278, 0);
+	cam.vup = vec3(0, 1, 0);
+
+	cam.defocus_angle = 0;
+	cam.lights = light_quad;
+
+	return setup;
+}
+
+inline scene_setup build_cornell_smoke() {
+	scene_setup setup;
+	hittable_list& world = setup.world;
+
+	auto red = make_shared<lambertian>(color(.65, .05, .05));
+	auto white = make_shared<lambertian>(color(.73, .73, .73));
+	auto green = make_shared<lambertian>(color(.12, .45, .15));
+	auto light = make_shared<diffuse_light>(color(7, 7, 7));
+
+	world.add(make_shared<quad>(point3(555, 0, 0), vec3(0, 555, 0), vec3(0, 0, 555), green));
+	world.add(make_shared<quad>(point3(0, 0, 0), vec3(0, 555, 0), vec3(0, 0, 555), red));
+	auto light_quad = make_shared<quad>(point3(113, 554, 127), vec3(330, 0, 0), vec3(0, 0, 305), light);
+	world.add(light_quad);
+	world.add(make_shared<quad>(point3(0, 555, 0), vec3(555, 0, 0), vec3(0, 0, 555), white));
+	world.add(make_shared<quad>(point3(0, 0, 0), vec3(555, 0, 0), vec3(0, 0, 555), white));
+	world.add(make_shared<quad>(point3(0, 0, 555), vec3(555, 0, 0), vec3(0, 555, 0), white));
+
+	// Box placements baked into the quad corners: no per-ray transform wrappers.
+	shared_ptr<hittable> box1 = box(point3(0, 0, 0), point3(165, 330, 165), white);
+	box1 = instance::apply(box1, affine::translation(vec3(265, 0, 295)) * affine::rotation_y(15), setup.arena);
+
+	shared_ptr<hittable> box2 = box(point3(0, 0, 0), point3(165, 165, 165), white);
+	box2 = instance::apply(box2, affine::translation(vec3(130, 0, 65)) * affine::rotation_y(-18), setup.arena);
+
+	world.add(make_shared<constant_medium>(box1, 0.01, color(0, 0, 0)));
+	world.add(make_shared<constant_medium>(box2, 0.01, color(1, 1, 1)));
+
+	camera& cam = setup.cam;
+
+	cam.aspect_ratio = 1.0;
+	cam.image_width = 600;
+	cam.samples_per_pixel = 200;
+	cam.max_depth = 50;
+	cam.background = color(0, 0, 0);
+
+	cam.vfov = 40;
+	cam.lookfrom = point3(278, 278, -800);
+	cam.lookat = point3(278, 278, 0);
+	cam.vup = vec3(0, 1, 0);
+
+	cam.defocus_angle = 0;
+	cam.motion_blur = false; // No moving geometry in this scene
+	cam.lights = light_quad;
+
+	return setup;
+}
+
+inline scene_setup build_cornell_box() {
+	scene_setup setup;
+	hittable_list& world = setup.world;
+
+	auto red = make_shared<lambertian>(color(.65, .05, .05));
+	auto white = make_shared<lambertian>(color(.73, .73, .73));
+	auto green = make_shared<lambertian>(color(.12, .45, .15));
+	auto light = make_shared<diffuse_light>(color(15, 15, 15));
+
+	world.add(make_shared<quad>(point3(555, 0, 0), vec3(0, 555, 0), vec3(0, 0, 555), green));
+	world.add(make_shared<quad>(point3(0, 0, 0), vec3(0, 555, 0), vec3(0, 0, 555), red));
+	auto light_quad = make_shared<quad>(point3(343, 554, 332), vec3(-130, 0, 0), vec3(0, 0, -105), light);
+	world.add(light_quad);
+	world.add(make_shared<quad>(point3(0, 0, 0), vec3(555, 0, 0), vec3(0, 0, 555), white));
+	world.add(make_shared<quad>(point3(555, 555, 555), vec3(-555, 0, 0), vec3(0, 0, -555), white));
+	world.add(make_shared<quad>(point3(0, 0, 555), vec3(555, 0, 0), vec3(0, 555, 0), white));
+
+	// Box placements baked into the quad corners: no per-ray transform wrappers.
+	shared_ptr<hittable> box1 = box(point3(0, 0, 0), point3(165, 330, 165), white);
+	world.add(instance::apply(box1, affine::translation(vec3(265, 0, 295)) * affine::rotation_y(15), setup.arena));
+
+	shared_ptr<hittable> box2 = box(point3(0, 0, 0), point3(165, 165, 165), white);
+	world.add(instance::apply(box2, affine::translation(vec3(130, 0, 65)) * affine::rotation_y(-18), setup.arena));
+
+	world.add(box(point3(130, 0, 65), point3(295, 165, 230), white));
+	world.add(box(point3(265, 0, 295), point3(430, 330, 460), white));
+
+	camera& cam = setup.cam;
+
+	cam.aspect_ratio = 1.0;
+	cam.image_width = 600;
+	cam.samples_per_pixel = 200;
+	cam.max_depth = 50;
+	cam.background = color(0, 0, 0);
+
+	cam.vfov = 40;
+	cam.lookfrom = point3(278, 278, -800);
+	cam.lookat = point3(278, 278, 0);
+	cam.vup = vec3(0, 1, 0);
+
+	cam.defocus_angle = 0;
+	cam.motion_blur = false; // No moving geometry in this scene
+	cam.lights = light_quad;
+
+	return setup;
+}
+
+inline scene_setup build_simple_light() {
+	scene_setup setup;
+	hittable_list& world = setup.world;
+
+	auto pertext = make_shared<noise_texture>(4);
+	world.add(make_shared<sphere>(point3(0, -1000, 0), 1000, make_shared<lambertian>(pertext)));
+	world.add(make_shared<sphere>(point3(0, 2, 0), 2, make_shared<lambertian>(pertext)));
+
+	auto difflight = make_shared<diffuse_light>(color(4, 4, 4));
+	auto light_sphere = make_shared<sphere>(point3(0, 7, 0), 2, difflight);
+	auto light_quad = make_shared<quad>(point3(3, 1, -2), vec3(2, 0, 0), vec3(0, 2, 0), difflight);
+	world.add(light_sphere);
+	world.add(light_quad);
+
+	auto lights = make_shared<hittable_list>(light_sphere);
+	lights->add(light_quad);
+
+	camera& cam = setup.cam;
+
+	cam.aspect_ratio = 16.0 / 9.0;
+	cam.image_width = 400;
+	cam.samples_per_pixel = 100;
+	cam.max_depth = 50;
+	cam.background = color(0, 0, 0);
+
+	cam.vfov = 20;
+	cam.lookfrom = point3(26, 3, 6);
+	cam.lookat = point3(0, 2, 0);
+	cam.vup = vec3(0, 1, 0);
+
+	cam.defocus_angle = 0;
+	cam.motion_blur = false; // No moving geometry in this scene
+	cam.lights = lights;
+
+	return setup;
+}
+
+inline scene_setup build_quads() {
+	scene_setup setup;
+	hittable_list& world = setup.world;
+
+	// Materials
+	auto left_red = make_shared<lambertian>(color(1.0, 0.2, 0.2));
+	auto back_green = make_shared<lambertian>(color(0.2, 1.0, 0.2));
+	auto right_blue = make_shared<lambertian>(color(0.2, 0.2, 1.0));
+	auto upper_orange = make_shared<lambertian>(color(1.0, 0.5, 0.0));
+	auto lower_teal = make_shared<lambertian>(color(0.2, 0.8, 0.8));
+
+	// Quads
+	world.add(make_shared<quad>(point3(-3, -2, 5), vec3(0, 0, -4), vec3(0, 4, 0), left_red));
+	world.add(make_shared<quad>(point3(-2, -2, 0), vec3(4, 0, 0), vec3(0, 4, 0), back_green));
+	world.add(make_shared<quad>(point3(3, -2, 1), vec3(0, 0, 4), vec3(0, 4, 0), right_blue));
+	world.add(make_shared<quad>(point3(-2, 3, 1), vec3(4, 0, 0), vec3(0, 0, 4), upper_orange));
+	world.add(make_shared<quad>(point3(-2, -3, 5), vec3(4, 0, 0), vec3(0, 0, -4), lower_teal));
+
+	camera& cam = setup.cam;
+
+	cam.aspect_ratio = 1.0;
+	cam.image_width = 400;
+	cam.samples_per_pixel = 100;
+	cam.max_depth = 50;
+	cam.background = color(0.70, 0.80, 1.00);
+
+	cam.vfov = 80;
+	cam.lookfrom = point3(0, 0, 9);
+	cam.lookat = point3(0, 0, 0);
+	cam.vup = vec3(0, 1, 0);
+
+	cam.defocus_angle = 0;
+	cam.motion_blur = false; // No moving geometry in this scene
+
+	return setup;
+}
+
+inline scene_setup build_perlin_spheres() {
+	scene_setup setup;
+	hittable_list& world = setup.world;
+
+	auto pertext = make_shared<noise_texture>(4);
+	world.add(make_shared<sphere>(point3(0, -1000, 0), 1000, make_shared<lambertian>(pertext)));
+	world.add(make_shared<sphere>(point3(0, 2, 0), 2, make_shared<lambertian>(pertext)));
+
+	camera& cam = setup.cam;
+
+	cam.aspect_ratio = 16.0 / 9.0;
+	cam.image_width = 400;
+	cam.samples_per_pixel = 100;
+	cam.max_depth = 50;
+	cam.background = color(0.70, 0.80, 1.00);
+
+	cam.vfov = 20;
+	cam.lookfrom = point3(13, 2, 3);
+	cam.lookat = point3(0, 0, 0);
+	cam.vup = vec3(0, 1, 0);
+
+	cam.defocus_angle = 0;
+	cam.motion_blur = false; // No moving geometry in this scene
+
+	return setup;
+}
+
+inline scene_setup build_earth() {
+	scene_setup setup;
+
+	auto earth_texture = make_shared<image_texture>("earthmap.jpg");
+	auto earth_surface = make_shared<lambertian>(earth_texture);
+	setup.world.add(make_shared<sphere>(point3(0, 0, 0), 2, earth_surface));
+
+	camera& cam = setup.cam;
+
+	cam.aspect_ratio = 16.0 / 9.0;
+	cam.image_width = 400;
+	cam.samples_per_pixel = 100;
+	cam.max_depth = 50;
+	cam.background = color(0.70, 0.80, 1.00);
+
+	cam.vfov = 20;
+	cam.lookfrom = point3(0, 0, 12);
+	cam.lookat = point3(0, 0, 0);
+	cam.vup = vec3(0, 1, 0);
+
+	cam.defocus_angle = 0;
+	cam.motion_blur = false; // No moving geometry in this scene
+
+	return setup;
+}
+
+inline scene_setup build_bounding_spheres() {
+	scene_setup setup;
+	hittable_list world;
+
+	auto checker = make_shared<checker_texture>(0.32, color(0.2, 0.3, 0.1), color(0.9, 0.9, 0.9));
+	world.add(make_shared<sphere>(point3(0, -1000, 0), 1000, make_shared<lambertian>(checker)));
+
+	for (int a = -11; a < 11; a++) {
+		for (int b = -11; b < 11; b++) {
+			auto choose_mat = random_double();
+			point3 center(a + 0.9 * random_double(), 0.2, b + 0.9 * random_double());
+
+			if ((center - point3(4, 0.2, 0)).length() > 0.9) {
+				shared_ptr<material> sphere_material;
+
+				if (choose_mat < 0.8) {
+					// diffuse
+					auto albedo = color::random() * color::random();
+					sphere_material = make_shared<lambertian>(albedo);
+					auto center2 = center + vec3(0, random_double(0, .5), 0);
+					world.add(make_shared<sphere>(center, center2, 0.2, sphere_material));
+				}
+				else if (choose_mat < 0.95) {
+					// metal
+					auto albedo = color::random(interval(0.5,1));
+					auto fuzz = random_double(0, 0.5);
+					sphere_material = make_shared<metal>(albedo, fuzz);
+					world.add(make_shared<sphere>(center, 0.2, sphere_material));
+				}
+				else {
+					// glass
+					sphere_material = make_shared<dielectric>(1.5);
+					world.add(make_shared<sphere>(center, 0.2, sphere_material));
+				}
+			}
+		}
+	}
+
+	auto material1 = make_shared<dielectric>(1.5);
+	world.add(make_shared<sphere>(point3(0, 1, 0), 1.0, material1));
+
+	auto material2 = make_shared<lambertian>(color(0.4, 0.2, 0.1));
+	world.add(make_shared<sphere>(point3(-4, 1, 0), 1.0, material2));
+
+	auto material3 = make_shared<metal>(color(0.7, 0.6, 0.5), 0.0);
+	world.add(make_shared<sphere>(point3(4, 1, 0), 1.0, material3));
+
+	// Create the BVH for performance
+	setup.world = hittable_list(make_shared<bvh_node>(world));
+
+	camera& cam = setup.cam;
+
+	cam.aspect_ratio = 16.0 / 9.0;
+	cam.image_width = 1200;
+	cam.samples_per_pixel = 500;
+	cam.max_depth = 50;
+	cam.background = color(0.70, 0.80, 1.00);
+
+	cam.vfov = 20;
+	cam.lookfrom = point3(13, 2, 3);
+	cam.lookat = point3(0, 0, 0);
+	cam.vup = vec3(0, 1, 0);
+
+	cam.defocus_angle = 0.6;
+	cam.focus_dist = 10.0;
+
+	return setup;
+}
+
+inline scene_setup build_checkered_spheres() {
+	scene_setup setup;
+	hittable_list& world = setup.world;
+
+	auto checker = make_shared<checker_texture>(0.32, color(0.2, 0.3, 0.1), color(0.9, 0.9, 0.9));
+
+	world.add(make_shared<sphere>(point3(0, -10, 0), 10, make_shared<lambertian>(checker)));
+	world.add(make_shared<sphere>(point3(0, 10, 0), 10, make_shared<lambertian>(checker)));
+
+	camera& cam = setup.cam;
+
+	cam.aspect_ratio = 16.0 / 9.0;
+	cam.image_width = 400;
+	cam.samples_per_pixel = 100;
+	cam.max_depth = 50;
+	cam.background = color(0.70, 0.80, 1.00);
+
+	cam.vfov = 20;
+	cam.lookfrom = point3(13, 2, 3);
+	cam.lookat = point3(0, 0, 0);
+	cam.vup = vec3(0, 1, 0);
+
+	cam.defocus_angle = 0;
+	cam.motion_blur = false; // No moving geometry in this scene
+
+	return setup;
+}
+#endif
@@ -2,6 +2,7 @@
 #define SPHERE_H
 
 #include "hittable.h"
+#include "onb.h"
 
 class sphere : public hittable {
 public:
@@ -55,13 +56,39 @@ public:
 		vec3 outward_normal = (rec.p - current_center) / radius;
 		rec.set_face_normal(r, outward_normal);
 		get_sphere_uv(outward_normal, rec.u, rec.v);
-		rec.mat = mat;
+		rec.uv_per_unit = 1 / (2 * pi * radius); // u spans 1 over the equator's circumference
+		rec.mat = mat.get();
 
 		return true;
 	}
 
 	aabb bounding_box() const override { return bbox; }
+
+	double pdf_value(const point3& origin, const vec3& direction) const override {
+		// Only valid for stationary spheres: the density is uniform over the cone of
+		// directions subtended by the sphere as seen from origin.
+		hit_record rec;
+		if (!this->hit(ray(origin, direction), interval(0.001, infinity), rec))
+			return 0;
+
+		double dist_squared = (center.at(0) - origin).length_squared();
+		double cos_theta_max = std::sqrt(1 - radius * radius / dist_squared);
+		double solid_angle = 2 * pi * (1 - cos_theta_max);
+
+		return 1 / solid_angle;
+	}
+
+	vec3 random(const point3& origin) const override {
+		vec3 direction = center.at(0) - origin;
+		double distance_squared = direction.length_squared();
+		onb uvw(direction);
+		return uvw.transform(random_to_sphere(radius, distance_squared));
+	}
+
 private:
+	friend class scene_file; // Serializer reads geometry and material references directly
+	friend class instance;   // Transform baking rewrites centers and radii in place
+
 	ray center;
 	double radius;
 	shared_ptr<material> mat;
@@ -81,5 +108,19 @@ private:
 		u = phi / (2 * pi);
 		v = theta / pi;
 	}
+
+	static vec3 random_to_sphere(double radius, double distance_squared) {
+		// Uniform direction within the cone subtended by a sphere of the given radius at
+		// the given squared distance, expressed around the +z axis.
+		double r1 = random_double();
+		double r2 = random_double();
+		double z = 1 + r2 * (std::sqrt(1 - radius * radius / distance_squared) - 1);
+
+		double phi = 2 * pi * r1;
+		double x = std::cos(phi) * std::sqrt(1 - z * z);
+		double y = std::sin(phi) * std::sqrt(1 - z * z);
+
+		return vec3(x, y, z);
+	}
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,216 @@
+#ifndef SPHERE_BATCH_H
+#define SPHERE_BATCH_H
+
+#include "hittable.h"
+#include "hittable_list.h"
+
+#include <algorithm>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/*
+ * Sphere Batch (structure-of-arrays primitive)
+ * --------------------------------------------
+ * Stores a group of stationary spheres as parallel center/radius arrays and intersects
+ * them four at a time with AVX2 (scalar loop otherwise). Compared to per-sphere
+ * hittables reached through virtual calls, a batch pays one virtual hit() for the whole
+ * group and keeps the quadratic-solve inputs contiguous in memory.
+ *
+ * Intended use: dense clusters of small spheres (the 1000-sphere block in final_scene)
+ * grouped into spatially coherent batches that sit at BVH leaves — see
+ * make_sphere_batches below. Moving spheres are not supported; keep those as regular
+ * sphere objects.
+ */
+
+class sphere_batch : public hittable {
+public:
+	sphere_batch() {}
+
+	void add(const point3& center, double radius, shared_ptr<material> mat) {
+		cx.push_back(center.x());
+		cy.push_back(center.y());
+		cz.push_back(center.z());
+		radii.push_back(std::fmax(0, radius));
+		materials.push_back(mat);
+
+		vec3 rvec = vec3(radius, radius, radius);
+		bbox = aabb(bbox, aabb(center - rvec, center + rvec));
+	}
+
+	size_t size() const { return radii.size(); }
+
+	bool hit(const ray& r, interval ray_t, hit_record& rec) const override {
+		double a = r.direction().length_squared();
+		double closest_so_far = ray_t.max;
+		int best = -1;
+
+		size_t count = radii.size();
+		size_t i = 0;
+
+#if defined(__AVX2__)
+		__m256d origin_x = _mm256_set1_pd(r.origin().x());
+		__m256d origin_y = _mm256_set1_pd(r.origin().y());
+		__m256d origin_z = _mm256_set1_pd(r.origin().z());
+		__m256d dir_x = _mm256_set1_pd(r.direction().x());
+		__m256d dir_y = _mm256_set1_pd(r.direction().y());
+		__m256d dir_z = _mm256_set1_pd(r.direction().z());
+		__m256d va = _mm256_set1_pd(a);
+		__m256d t_min = _mm256_set1_pd(ray_t.min);
+
+		for (; i + 4 <= count; i += 4) {
+			__m256d oc_x = _mm256_sub_pd(_mm256_loadu_pd(&cx[i]), origin_x);
+			__m256d oc_y = _mm256_sub_pd(_mm256_loadu_pd(&cy[i]), origin_y);
+			__m256d oc_z = _mm256_sub_pd(_mm256_loadu_pd(&cz[i]), origin_z);
+			__m256d radius = _mm256_loadu_pd(&radii[i]);
+
+			// Same quadratic as sphere::hit, four lanes wide
+			__m256d h = _mm256_add_pd(_mm256_mul_pd(oc_x, dir_x),
+				_mm256_add_pd(_mm256_mul_pd(oc_y, dir_y), _mm256_mul_pd(oc_z, dir_z)));
+			__m256d c = _mm256_sub_pd(
+				_mm256_add_pd(_mm256_mul_pd(oc_x, oc_x),
+					_mm256_add_pd(_mm256_mul_pd(oc_y, oc_y), _mm256_mul_pd(oc_z, oc_z))),
+				_mm256_mul_pd(radius, radius));
+			__m256d discriminant = _mm256_sub_pd(_mm256_mul_pd(h, h), _mm256_mul_pd(va, c));
+
+			__m256d hit_mask = _mm256_cmp_pd(discriminant, _mm256_setzero_pd(), _CMP_GE_OQ);
+			if (_mm256_movemask_pd(hit_mask) == 0)
+				continue;
+
+			__m256d sqrt_discriminant = _mm256_sqrt_pd(_mm256_max_pd(discriminant, _mm256_setzero_pd()));
+			__m256d near_root = _mm256_div_pd(_mm256_sub_pd(h, sqrt_discriminant), va);
+			__m256d far_root = _mm256_div_pd(_mm256_add_pd(h, sqrt_discriminant), va);
+
+			__m256d t_max = _mm256_set1_pd(closest_so_far);
+
+			// Prefer the near root; lanes where it is out of range fall back to the far root
+			__m256d near_valid = _mm256_and_pd(
+				_mm256_cmp_pd(near_root, t_min, _CMP_GT_OQ),
+				_mm256_cmp_pd(near_root, t_max, _CMP_LT_OQ));
+			__m256d root = _mm256_blendv_pd(far_root, near_root, near_valid);
+
+			__m256d valid = _mm256_and_pd(hit_mask, _mm256_and_pd(
+				_mm256_cmp_pd(root, t_min, _CMP_GT_OQ),
+				_mm256_cmp_pd(root, t_max, _CMP_LT_OQ)));
+
+			int lanes = _mm256_movemask_pd(valid);
+			if (lanes == 0)
+				continue;
+
+			double roots[4];
+			_mm256_storeu_pd(roots, root);
+
+			for (int lane = 0; lane < 4; lane++) {
+				if ((lanes & (1 << lane)) && roots[lane] < closest_so_far) {
+					closest_so_far = roots[lane];
+					best = int(i) + lane;
+				}
+			}
+		}
+#endif
+
+		// Scalar tail (and the whole loop when AVX2 is unavailable)
+		for (; i < count; i++) {
+			vec3 oc = point3(cx[i], cy[i], cz[i]) - r.origin();
+			double h = dot(r.direction(), oc);
+			double c = oc.length_squared() - radii[i] * radii[i];
+			double discriminant = h * h - a * c;
+
+			if (discriminant < 0)
+				continue;
+
+			double sqrt_discriminant = std::sqrt(discriminant);
+			double root = (h - sqrt_discriminant) / a;
+			if (root <= ray_t.min || root >= closest_so_far) {
+				root = (h + sqrt_discriminant) / a;
+				if (root <= ray_t.min || root >= closest_so_far)
+					continue;
+			}
+
+			closest_so_far = root;
+			best = int(i);
+		}
+
+		if (best < 0)
+			return false;
+
+		rec.t = closest_so_far;
+		rec.p = r.at(rec.t);
+		vec3 outward_normal = (rec.p - point3(cx[best], cy[best], cz[best])) / radii[best];
+		rec.set_face_normal(r, outward_normal);
+		get_sphere_uv(outward_normal, rec.u, rec.v);
+		rec.uv_per_unit = 1 / (2 * pi * radii[best]);
+		rec.mat = materials[best].get();
+
+		return true;
+	}
+
+	aabb bounding_box() const override { return bbox; }
+
+private:
+	friend class scene_file;
+	friend class instance;
+
+	std::vector<double> cx, cy, cz;
+	std::vector<double> radii;
+	std::vector<shared_ptr<material>> materials;
+	aabb bbox;
+
+	static void get_sphere_uv(const point3& p, double& u, double& v) {
+		// Same mapping as sphere::get_sphere_uv
+		auto theta = std::acos(-p.y());
+		auto phi = std::atan2(-p.z(), p.x()) + pi;
+
+		u = phi / (2 * pi);
+		v = theta / pi;
+	}
+};
+
+struct sphere_desc {
+	point3 center;
+	double radius;
+	shared_ptr<material> mat;
+};
+
+// Recursively median-split the spheres on the longest axis of their centers until each
+// group fits in one batch, so batches stay spatially tight and BVH-friendly.
+inline void partition_sphere_batches(std::vector<sphere_desc>& spheres, size_t start, size_t end, size_t max_batch, hittable_list& out) {
+	if (end - start <= max_batch) {
+		auto batch = make_shared<sphere_batch>();
+		for (size_t i = start; i < end; i++)
+			batch->add(spheres[i].center, spheres[i].radius, spheres[i].mat);
+		out.add(batch);
+		return;
+	}
+
+	point3 min_center(infinity, infinity, infinity);
+	point3 max_center(-infinity, -infinity, -infinity);
+	for (size_t i = start; i < end; i++) {
+		for (int axis = 0; axis < 3; axis++) {
+			min_center[axis] = std::fmin(min_center[axis], spheres[i].center[axis]);
+			max_center[axis] = std::fmax(max_center[axis], spheres[i].center[axis]);
+		}
+	}
+
+	vec3 extent = max_center - min_center;
+	int axis = (extent.x() > extent.y())
+		? (extent.x() > extent.z() ? 0 : 2)
+		: (extent.y() > extent.z() ? 1 : 2);
+
+	size_t mid = start + (end - start) / 2;
+	std::nth_element(spheres.begin() + start, spheres.begin() + mid, spheres.begin() + end,
+		[axis](const sphere_desc& a, const sphere_desc& b) { return a.center[axis] < b.center[axis]; });
+
+	partition_sphere_batches(spheres, start, mid, max_batch, out);
+	partition_sphere_batches(spheres, mid, end, max_batch, out);
+}
+
+inline hittable_list make_sphere_batches(std::vector<sphere_desc> spheres, size_t max_batch = 64) {
+	hittable_list out;
+	if (!spheres.empty())
+		partition_sphere_batches(spheres, 0, spheres.size(), max_batch, out);
+	return out;
+}
+#endif
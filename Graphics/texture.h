@@ -10,6 +10,13 @@ public:
 	virtual ~texture() = default;
 
 	virtual color value(double u, double v, const point3& p) const = 0;
+
+	// Footprint-aware overload: footprint is the approximate uv-space width the ray
+	// covers at the hit (0 when unknown). Textures that can prefilter (image_texture)
+	// use it to pick a mip level; everything else ignores it.
+	virtual color value(double u, double v, const point3& p, double footprint) const {
+		return value(u, v, p);
+	}
 };
 
 class solid_color : public texture {
@@ -23,6 +30,8 @@ public:
     }
 
 private:
+    friend class scene_file;
+
     color albedo;
 };
 
@@ -45,6 +54,8 @@ public:
     }
 
 private:
+    friend class scene_file;
+
     double inv_scale;
     shared_ptr<texture> even;
     shared_ptr<texture> odd;
@@ -52,24 +63,62 @@ private:
 
 class image_texture : public texture {
 public:
-    image_texture(const char* filename) : image(filename) {}
+    // Loads through the process-wide cache: repeated references to the same file share
+    // one decoded image instead of re-reading and re-decoding it per material.
+    image_texture(const char* filename) : image(load_image_cached(filename)), filename(filename) {}
 
     color value(double u, double v, const point3& p) const override {
-        if (image.height() <= 0) return color(0, 1, 1); // Fail safe for when imagew failed to load
+        return value(u, v, p, 0);
+    }
+
+    color value(double u, double v, const point3& p, double footprint) const override {
+        if (image->height() <= 0) return color(0, 1, 1); // Fail safe for when imagew failed to load
 
         const interval uv_range = interval(0,1);
         u = uv_range.clamp(u);
         v = 1.0 - uv_range.clamp(v);
 
-        int i = int(u * image.width());
-        int j = int(v * image.height());
-        auto pixel = image.pixel_data(i, j);
+        // Pick the mip level whose texels are about the size of the ray's footprint, so
+        // a distant or grazing hit reads a prefiltered texel instead of aliasing across
+        // dozens of full-resolution ones. Footprint 0 (unknown) samples the full image.
+        double texels_covered = footprint * image->width();
+        int level = 0;
+        if (texels_covered > 1)
+            level = std::min(int(std::log2(texels_covered) + 0.5), image->mip_levels() - 1);
+
+        return sample_bilinear(level, u, v);
+    }
+
+private:
+    friend class scene_file;
+
+    std::shared_ptr<const rtw_image> image;
+    std::string filename; // Kept so the scene serializer can store the image by reference
+
+    color sample_bilinear(int level, double u, double v) const {
+        int level_width = image->mip_width(level);
+        int level_height = image->mip_height(level);
+
+        // Texel centers sit at half-integer coordinates
+        double x = u * level_width - 0.5;
+        double y = v * level_height - 0.5;
+        int x0 = int(std::floor(x));
+        int y0 = int(std::floor(y));
+        double fx = x - x0;
+        double fy = y - y0;
+
+        return (1 - fx) * (1 - fy) * texel(level, x0, y0)
+             + fx * (1 - fy) * texel(level, x0 + 1, y0)
+             + (1 - fx) * fy * texel(level, x0, y0 + 1)
+             + fx * fy * texel(level, x0 + 1, y0 + 1);
+    }
+
+    color texel(int level, int x, int y) const {
+        auto pixel = image->mip_pixel_data(level, x, y);
 
         double color_scale = 1.0 / 255.0;
         return color(color_scale * pixel[0], color_scale * pixel[1], color_scale * pixel[2]);
     }
-private:
-    rtw_image image;
 };
 
 class noise_texture : public texture {
@@ -80,6 +129,8 @@ public:
         return color(.5, .5, .5) * (1 + std::sin(scale * p.z() + 10 * noise.turb(p, 7)));
     }
 private:
+    friend class scene_file;
+
     perlin noise;
     double scale;
 };
@@ -0,0 +1,261 @@
+#ifndef TRANSFORM_H
+#define TRANSFORM_H
+
+#include "bvh.h"
+#include "scene.h"
+#include "sphere.h"
+#include "sphere_batch.h"
+
+/*
+ * Affine transforms and instancing
+ * --------------------------------
+ * translate and rotate_y each add a virtual-call layer that transforms the ray on
+ * every hit() — a translate(rotate_y(...)) stack costs two extra hops per ray before
+ * the wrapped geometry is even reached. This header collapses that cost two ways:
+ *
+ * - instance: one node carrying a cached affine transform and its inverse. Stacked
+ *   instances compose into a single hop at construction time, so an arbitrarily deep
+ *   transform stack still costs one ray transform per hit().
+ *
+ * - instance::bake(): folds a static transform directly into the geometry (sphere
+ *   centers, quad corners, sphere_batch arrays) at scene-build time, so the per-ray
+ *   cost disappears entirely. BVHs are rebuilt over the baked primitives. Baking
+ *   spheres requires a rigid (rotation + translation + uniform scale) transform,
+ *   which is everything the scene functions use; bake() returns null for anything it
+ *   cannot fold and instance::apply() falls back to a single instance node.
+ */
+
+// Row-major 3x4 affine transform: linear part in columns 0-2, translation in column 3.
+// (The fourth matrix row is implicitly 0 0 0 1, so it is never stored.)
+struct affine {
+	double m[3][4];
+
+	static affine identity() {
+		affine t = {};
+		t.m[0][0] = t.m[1][1] = t.m[2][2] = 1;
+		return t;
+	}
+
+	static affine translation(const vec3& offset) {
+		affine t = identity();
+		t.m[0][3] = offset.x();
+		t.m[1][3] = offset.y();
+		t.m[2][3] = offset.z();
+		return t;
+	}
+
+	static affine rotation_y(double degrees) {
+		double radians = degrees_to_radians(degrees);
+		return rotation_y_from(std::sin(radians), std::cos(radians));
+	}
+
+	static affine rotation_y_from(double sin_theta, double cos_theta) {
+		affine t = identity();
+		t.m[0][0] = cos_theta;  t.m[0][2] = sin_theta;
+		t.m[2][0] = -sin_theta; t.m[2][2] = cos_theta;
+		return t;
+	}
+
+	point3 apply_point(const point3& p) const {
+		return point3(
+			m[0][0] * p.x() + m[0][1] * p.y() + m[0][2] * p.z() + m[0][3],
+			m[1][0] * p.x() + m[1][1] * p.y() + m[1][2] * p.z() + m[1][3],
+			m[2][0] * p.x() + m[2][1] * p.y() + m[2][2] * p.z() + m[2][3]);
+	}
+
+	vec3 apply_vector(const vec3& v) const {
+		return vec3(
+			m[0][0] * v.x() + m[0][1] * v.y() + m[0][2] * v.z(),
+			m[1][0] * v.x() + m[1][1] * v.y() + m[1][2] * v.z(),
+			m[2][0] * v.x() + m[2][1] * v.y() + m[2][2] * v.z());
+	}
+
+	// Uniform scale factor of the linear part, or false if the transform shears or
+	// scales axes unevenly (in which case spheres would not stay spheres when baked).
+	bool uniform_scale(double& scale) const {
+		vec3 col[3];
+		for (int i = 0; i < 3; i++)
+			col[i] = vec3(m[0][i], m[1][i], m[2][i]);
+
+		double s0 = col[0].length(), s1 = col[1].length(), s2 = col[2].length();
+		const double eps = 1e-9;
+		if (std::fabs(s0 - s1) > eps || std::fabs(s1 - s2) > eps)
+			return false;
+		if (std::fabs(dot(col[0], col[1])) > eps || std::fabs(dot(col[1], col[2])) > eps || std::fabs(dot(col[0], col[2])) > eps)
+			return false;
+
+		scale = s0;
+		return true;
+	}
+};
+
+// Composition: (a * b) applies b first, then a — matching matrix multiplication.
+inline affine operator*(const affine& a, const affine& b) {
+	affine out = {};
+	for (int row = 0; row < 3; row++) {
+		for (int column = 0; column < 4; column++) {
+			out.m[row][column] = a.m[row][0] * b.m[0][column]
+			                   + a.m[row][1] * b.m[1][column]
+			                   + a.m[row][2] * b.m[2][column];
+		}
+		out.m[row][3] += a.m[row][3];
+	}
+	return out;
+}
+
+inline affine inverse(const affine& t) {
+	// Invert the 3x3 linear part by its adjugate, then the translation follows as
+	// -inverse_linear * translation.
+	const double (*m)[4] = t.m;
+	double det = m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1])
+	           - m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0])
+	           + m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+	double inv_det = 1.0 / det;
+
+	affine out = {};
+	out.m[0][0] = (m[1][1] * m[2][2] - m[1][2] * m[2][1]) * inv_det;
+	out.m[0][1] = (m[0][2] * m[2][1] - m[0][1] * m[2][2]) * inv_det;
+	out.m[0][2] = (m[0][1] * m[1][2] - m[0][2] * m[1][1]) * inv_det;
+	out.m[1][0] = (m[1][2] * m[2][0] - m[1][0] * m[2][2]) * inv_det;
+	out.m[1][1] = (m[0][0] * m[2][2] - m[0][2] * m[2][0]) * inv_det;
+	out.m[1][2] = (m[0][2] * m[1][0] - m[0][0] * m[1][2]) * inv_det;
+	out.m[2][0] = (m[1][0] * m[2][1] - m[1][1] * m[2][0]) * inv_det;
+	out.m[2][1] = (m[0][1] * m[2][0] - m[0][0] * m[2][1]) * inv_det;
+	out.m[2][2] = (m[0][0] * m[1][1] - m[0][1] * m[1][0]) * inv_det;
+
+	vec3 inv_translation = -out.apply_vector(vec3(m[0][3], m[1][3], m[2][3]));
+	out.m[0][3] = inv_translation.x();
+	out.m[1][3] = inv_translation.y();
+	out.m[2][3] = inv_translation.z();
+	return out;
+}
+
+class instance : public hittable {
+public:
+	instance(shared_ptr<hittable> object, const affine& transform) : hittable_object(object), forward(transform) {
+		// Collapse stacked instances so any depth of transforms stays a single hop.
+		while (instance* inner = dynamic_cast<instance*>(hittable_object.get())) {
+			forward = forward * inner->forward;
+			hittable_object = inner->hittable_object;
+		}
+		inv = inverse(forward);
+
+		// Transform the eight corners of the child's box and take their bounds.
+		aabb child_box = hittable_object->bounding_box();
+		point3 min(infinity, infinity, infinity);
+		point3 max(-infinity, -infinity, -infinity);
+		for (int i = 0; i < 8; i++) {
+			point3 corner(
+				(i & 1) ? child_box.x.max : child_box.x.min,
+				(i & 2) ? child_box.y.max : child_box.y.min,
+				(i & 4) ? child_box.z.max : child_box.z.min);
+			point3 transformed = forward.apply_point(corner);
+			for (int axis = 0; axis < 3; axis++) {
+				min[axis] = std::fmin(min[axis], transformed[axis]);
+				max[axis] = std::fmax(max[axis], transformed[axis]);
+			}
+		}
+		bbox = aabb(min, max);
+	}
+
+	bool hit(const ray& r, interval ray_t, hit_record& rec) const override {
+		// One transform into object space; t values are shared between the two rays
+		// because the direction is transformed as a vector, not renormalized.
+		ray local(inv.apply_point(r.origin()), inv.apply_vector(r.direction()), r.time());
+
+		if (!hittable_object->hit(local, ray_t, rec))
+			return false;
+
+		rec.p = forward.apply_point(rec.p);
+		// Normals transform by the inverse transpose of the linear part, which is the
+		// transpose of the cached inverse.
+		rec.normal = unit_vector(vec3(
+			inv.m[0][0] * rec.normal.x() + inv.m[1][0] * rec.normal.y() + inv.m[2][0] * rec.normal.z(),
+			inv.m[0][1] * rec.normal.x() + inv.m[1][1] * rec.normal.y() + inv.m[2][1] * rec.normal.z(),
+			inv.m[0][2] * rec.normal.x() + inv.m[1][2] * rec.normal.y() + inv.m[2][2] * rec.normal.z()));
+
+		return true;
+	}
+
+	aabb bounding_box() const override { return bbox; }
+
+	// Folds the transform into the object's geometry inside owner's arenas, returning
+	// null when some part (an unknown hittable type, or a sphere under a non-rigid
+	// transform) cannot be baked.
+	static shared_ptr<hittable> bake(const shared_ptr<hittable>& object, const affine& transform, scene& owner) {
+		if (const sphere* s = dynamic_cast<const sphere*>(object.get())) {
+			double scale;
+			if (!transform.uniform_scale(scale))
+				return nullptr;
+
+			point3 center1 = transform.apply_point(s->center.at(0));
+			if (s->center.direction().length_squared() > 0)
+				return owner.make<sphere>(center1, transform.apply_point(s->center.at(1)), s->radius * scale, s->mat);
+			return owner.make<sphere>(center1, s->radius * scale, s->mat);
+		}
+
+		if (const quad* q = dynamic_cast<const quad*>(object.get())) {
+			return owner.make<quad>(transform.apply_point(q->Q), transform.apply_vector(q->u), transform.apply_vector(q->v), q->mat);
+		}
+
+		if (const sphere_batch* batch = dynamic_cast<const sphere_batch*>(object.get())) {
+			double scale;
+			if (!transform.uniform_scale(scale))
+				return nullptr;
+
+			auto baked = owner.make<sphere_batch>();
+			for (size_t i = 0; i < batch->radii.size(); i++)
+				baked->add(transform.apply_point(point3(batch->cx[i], batch->cy[i], batch->cz[i])), batch->radii[i] * scale, batch->materials[i]);
+			return baked;
+		}
+
+		if (const hittable_list* list = dynamic_cast<const hittable_list*>(object.get())) {
+			auto baked = owner.make<hittable_list>();
+			for (const shared_ptr<hittable>& child : list->hittables) {
+				shared_ptr<hittable> baked_child = bake(child, transform, owner);
+				if (!baked_child)
+					return nullptr;
+				baked->add(baked_child);
+			}
+			return baked;
+		}
+
+		if (const bvh_flat* flat = dynamic_cast<const bvh_flat*>(object.get())) {
+			hittable_list baked;
+			for (const shared_ptr<hittable>& child : flat->primitives) {
+				shared_ptr<hittable> baked_child = bake(child, transform, owner);
+				if (!baked_child)
+					return nullptr;
+				baked.add(baked_child);
+			}
+			return owner.make<bvh_flat>(baked, flat->build_mode);
+		}
+
+		// Existing wrappers fold into the running transform and disappear.
+		if (const translate* t = dynamic_cast<const translate*>(object.get()))
+			return bake(t->hittable_object, transform * affine::translation(t->offset), owner);
+
+		if (const rotate_y* rot = dynamic_cast<const rotate_y*>(object.get()))
+			return bake(rot->hittable_object, transform * affine::rotation_y_from(rot->sin_theta, rot->cos_theta), owner);
+
+		if (const instance* inst = dynamic_cast<const instance*>(object.get()))
+			return bake(inst->hittable_object, transform * inst->forward, owner);
+
+		return nullptr;
+	}
+
+	// Bakes when possible, otherwise wraps the object in a single instance node.
+	static shared_ptr<hittable> apply(const shared_ptr<hittable>& object, const affine& transform, scene& owner) {
+		if (shared_ptr<hittable> baked = bake(object, transform, owner))
+			return baked;
+		return owner.make<instance>(object, transform);
+	}
+
+private:
+	friend class scene_file;
+
+	shared_ptr<hittable> hittable_object;
+	affine forward, inv;
+	aabb bbox;
+};
+#endif
@@ -6,18 +6,18 @@
 class vec3
 {
 public:
-	double e[3];
+	real e[3];
 
 	vec3() : e{0,0,0} {}
-	vec3(double e0, double e1, double e2) : e{ e0, e1, e2 } {}
+	vec3(real e0, real e1, real e2) : e{ e0, e1, e2 } {}
 
-	double x() const { return e[0]; }
-	double y() const { return e[1]; }
-	double z() const { return e[2]; }
+	real x() const { return e[0]; }
+	real y() const { return e[1]; }
+	real z() const { return e[2]; }
 
 	vec3 operator-() const { return vec3(-e[0], -e[1], -e[2]); }
-	double operator[](int i) const { return e[i]; }
-	double& operator[](int i) { return e[i]; }
+	real operator[](int i) const { return e[i]; }
+	real& operator[](int i) { return e[i]; }
 
 	vec3& operator +=(const vec3& v) {
 		e[0] += v.e[0];
@@ -26,22 +26,22 @@ public:
 		return *this;
 	}
 
-	vec3& operator*=(double t) {
+	vec3& operator*=(real t) {
 		e[0] *= t;
 		e[1] *= t;
 		e[2] *= t;
 		return *this;
 	}
 
-	vec3& operator/=(double t) {
+	vec3& operator/=(real t) {
 		return *this *= 1 / t;
 	}
 
-	double length() const {
+	real length() const {
 		return sqrt(length_squared());
 	}
 
-	double length_squared() const {
+	real length_squared() const {
 		return e[0] * e[0] + e[1] * e[1] + e[2] * e[2];
 	}
 
@@ -52,11 +52,11 @@ public:
 	}
 
 	static vec3 random() {
-		return vec3(random_double(), random_double(), random_double());
+		return vec3(real(random_double()), real(random_double()), real(random_double()));
 	}
 
 	static vec3 random(interval range) {
-		return vec3(random_double(range.min, range.max), random_double(range.min, range.max), random_double(range.min, range.max));
+		return vec3(real(random_double(range.min, range.max)), real(random_double(range.min, range.max)), real(random_double(range.min, range.max)));
 	}
 };
 
@@ -78,18 +78,18 @@ inline vec3 operator*(const vec3& u, const vec3& v) {
 	return vec3(u.e[0] * v.e[0], u.e[1] * v.e[1], u.e[2] * v.e[2]);
 }
 
-inline vec3 operator*(double t, const vec3& v) {
+inline vec3 operator*(real t, const vec3& v) {
 	return vec3(t * v.e[0], t * v.e[1], t * v.e[2]);
 }
 
-inline vec3 operator*(const vec3& v, double t) {
+inline vec3 operator*(const vec3& v, real t) {
 	return t * v;
 }
 
-inline vec3 operator/(const vec3& v, double t) {
+inline vec3 operator/(const vec3& v, real t) {
 	return (1/t) * v;
 }
-inline double dot(const vec3& u, const vec3& v) {
+inline real dot(const vec3& u, const vec3& v) {
 	return u.e[0] * v.e[0]
 		+ u.e[1] * v.e[1]
 		+ u.e[2] * v.e[2];
@@ -106,22 +106,50 @@ inline vec3 unit_vector(const vec3& v) {
 }
 
 inline vec3 random_in_unit_disk() {
-	while (true) {
-		vec3 p = vec3(random_double(-1, 1), random_double(-1, 1), 0);
-		if (p.length_squared() < 1)
-			return p;
+	// Concentric (Shirley-Chiu) square-to-disk mapping: analytic and loop-free where
+	// the old rejection loop threw away ~21% of draws, and it keeps stratified input
+	// samples well distributed on the disk. Sits in the defocus path of every primary
+	// ray, so the fixed cost matters.
+	double a = random_double(-1, 1);
+	double b = random_double(-1, 1);
+
+	if (a == 0 && b == 0)
+		return vec3(0, 0, 0);
+
+	double r, phi;
+	if (a * a > b * b) {
+		r = a;
+		phi = (pi / 4) * (b / a);
 	}
+	else {
+		r = b;
+		phi = (pi / 2) - (pi / 4) * (a / b);
+	}
+
+	return vec3(real(r * std::cos(phi)), real(r * std::sin(phi)), 0);
 }
 
 inline vec3 random_unit_vector() {
-	while (true) {
-		point3 p = vec3::random(interval(-1, 1));
-		double len_sqr = p.length_squared();
+	// Analytic sphere sampling: cos(elevation) uniform in [-1, 1], azimuth uniform.
+	// Fixed cost — two RNG draws, a sqrt, and a sin/cos pair — where the old rejection
+	// loop discarded ~48% of cube draws and re-drew three randoms each time, with an
+	// unpredictable branch in the innermost scatter path.
+	double z = 1 - 2 * random_double();
+	double r = std::sqrt(std::fmax(0.0, 1 - z * z));
+	double phi = 2 * pi * random_double();
+
+	return vec3(real(r * std::cos(phi)), real(r * std::sin(phi)), real(z));
+}
 
-		// Due to floating precision, a really small value can underflow to zero when squared, we need to ban this location really close to the center.
-		if (1e-160 < len_sqr && len_sqr <= 1)
-			return p / sqrt(len_sqr);
-	}
+inline vec3 random_cosine_direction() {
+	// Cosine-weighted hemisphere around +z (pdf = cos(theta) / pi) by Malley's method:
+	// a concentric disk sample projected up onto the hemisphere. Never degenerate, so
+	// callers need no near-zero fallback; express it around a surface normal with
+	// onb::transform.
+	vec3 p = random_in_unit_disk();
+	double z = std::sqrt(std::fmax(0.0, 1 - double(p.length_squared())));
+
+	return vec3(p.x(), p.y(), real(z));
 }
 
 // WARNING: This implementation is simple but costly in the performance see Von Mises Distribution for potential improvement.
@@ -138,7 +166,7 @@ inline vec3 reflect(const vec3& v, const vec3& n) {
 }
 
 // uv represents the refracted ray, n the normal and etai_over_etat ni/nt
-inline vec3 refract(const vec3& uv, const vec3& n, double etai_over_etat) {
+inline vec3 refract(const vec3& uv, const vec3& n, real etai_over_etat) {
 	// Since uv and n are unit vectors a*b = cos(theta)
 	float cos_theta = std::fmin(dot(-uv, n), 1.0);
 